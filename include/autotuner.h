@@ -0,0 +1,165 @@
+#ifndef AUTOTUNER_H
+#define AUTOTUNER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "computeShader.h"
+
+// Picks the fastest WORKGROUP_SIZE per compute pass for the current device.
+//
+// Each candidate size is compiled as a ComputeShader variant and timed with
+// GL_TIME_ELAPSED queries over a set of particle counts; the size with the lowest
+// geometric-mean time wins. Winners are persisted per renderer/driver string, so
+// switching GPUs (or running under llvmpipe) tunes again instead of reusing them.
+class Autotuner {
+public:
+    inline static std::string path = "autotune.cfg";
+
+    // Runs one timed execution of the pass for 'count' particles. The shader is
+    // already bound to the candidate variant when this is called.
+    using PassRunner = std::function<void(ComputeShader& shader, unsigned int count)>;
+
+    // Stored winner for this device, or 0 if the pass has not been tuned here
+    static unsigned int lookup(const std::string& pass) {
+        std::string device = deviceString();
+        for (const Entry& entry : readEntries()) {
+            if (entry.device == device && entry.pass == pass) return entry.workgroupSize;
+        }
+        return 0;
+    }
+
+    static unsigned int tune(const std::string& pass, ComputeShader& shader,
+                             const std::vector<unsigned int>& counts, const PassRunner& run,
+                             bool verbose = false) {
+        const int WARMUP = 2;
+        const int SAMPLES = 5;
+
+        GLuint query;
+        glGenQueries(1, &query);
+
+        unsigned int best = 0;
+        double bestScore = 0.0;
+        for (unsigned int size : candidateSizes()) {
+            if (!shader.setDefine("WORKGROUP_SIZE", std::to_string(size))) continue; // Over a shared-memory limit, say
+            shader.use();
+
+            double logSum = 0.0;
+            for (unsigned int count : counts) {
+                std::vector<GLuint64> samples;
+                for (int i = 0; i < WARMUP + SAMPLES; i++) {
+                    glBeginQuery(GL_TIME_ELAPSED, query);
+                    run(shader, count);
+                    glEndQuery(GL_TIME_ELAPSED);
+                    // Keep successive runs from overlapping in the measurement
+                    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+                    GLuint64 ns = 0;
+                    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+                    if (i >= WARMUP) samples.push_back(ns);
+                }
+                std::nth_element(samples.begin(), samples.begin() + SAMPLES / 2, samples.end());
+                double median = static_cast<double>(std::max<GLuint64>(samples[SAMPLES / 2], 1));
+                logSum += std::log(median);
+
+                if (verbose) {
+                    std::cout << std::setw(10) << pass << "  wg " << std::setw(4) << size
+                              << "  n " << std::setw(6) << count
+                              << "  " << std::fixed << std::setprecision(3) << median / 1e6 << " ms\n";
+                }
+            }
+
+            double score = logSum / counts.size();
+            if (best == 0 || score < bestScore) {
+                best = size;
+                bestScore = score;
+            }
+        }
+        glDeleteQueries(1, &query);
+
+        // Tuning wrote buffers behind the BarrierTracker's back
+        glMemoryBarrier(GL_ALL_BARRIER_BITS);
+
+        if (best == 0) {
+            // Nothing built: leave the shader as it was and tune again next launch
+            std::cerr << "Autotune: no workgroup size builds for " << pass << "\n";
+            return shader.workgroupSize();
+        }
+        shader.setDefine("WORKGROUP_SIZE", std::to_string(best));
+        store(pass, best);
+        std::cout << "Autotune: " << pass << " -> workgroup size " << best << "\n";
+        return best;
+    }
+
+    // Powers of two the device can run, from 32 up to its limits
+    static std::vector<unsigned int> candidateSizes() {
+        GLint maxInvocations = 0;
+        GLint maxSizeX = 0;
+        glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &maxInvocations);
+        glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 0, &maxSizeX);
+        unsigned int limit = static_cast<unsigned int>(std::min(maxInvocations, maxSizeX));
+
+        std::vector<unsigned int> sizes;
+        for (unsigned int size = 32; size <= 1024 && size <= limit; size *= 2) sizes.push_back(size);
+        if (sizes.empty()) sizes.push_back(std::max(limit, 1u));
+        return sizes;
+    }
+
+private:
+    struct Entry {
+        std::string device;
+        std::string pass;
+        unsigned int workgroupSize;
+    };
+
+    static std::string deviceString() {
+        auto str = [](GLenum name) {
+            const GLubyte* s = glGetString(name);
+            return s ? std::string(reinterpret_cast<const char*>(s)) : std::string();
+        };
+        return str(GL_RENDERER) + " | " + str(GL_VERSION);
+    }
+
+    // One "device<TAB>pass<TAB>size" line per entry
+    static std::vector<Entry> readEntries() {
+        std::vector<Entry> entries;
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            Entry entry;
+            std::string size;
+            if (std::getline(fields, entry.device, '\t') && std::getline(fields, entry.pass, '\t') &&
+                std::getline(fields, size)) {
+                entry.workgroupSize = static_cast<unsigned int>(std::strtoul(size.c_str(), nullptr, 10));
+                if (entry.workgroupSize > 0) entries.push_back(entry);
+            }
+        }
+        return entries;
+    }
+
+    static void store(const std::string& pass, unsigned int size) {
+        std::string device = deviceString();
+        std::vector<Entry> entries = readEntries();
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const Entry& e) {
+            return e.device == device && e.pass == pass;
+        }), entries.end());
+        entries.push_back({ device, pass, size });
+
+        std::ofstream out(path);
+        for (const Entry& entry : entries) {
+            out << entry.device << '\t' << entry.pass << '\t' << entry.workgroupSize << '\n';
+        }
+    }
+};
+
+#endif // AUTOTUNER_H
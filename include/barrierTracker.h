@@ -0,0 +1,151 @@
+#ifndef BARRIER_TRACKER_H
+#define BARRIER_TRACKER_H
+
+#include <glad/glad.h>
+
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// How a pass consumes a buffer that may have been written by an earlier shader.
+// Each usage maps to the glMemoryBarrier bit that makes shader writes visible to it.
+enum class Usage {
+    ShaderStorage, // SSBO read in any shader stage (compute, vertex, fragment)
+    Uniform,       // bound as a UBO
+    VertexAttrib,  // sourced as vertex attributes
+    Command,       // indirect dispatch/draw arguments
+    BufferUpdate,  // glBufferSubData, glGetBufferSubData, glMapBuffer, glCopyBufferSubData
+};
+
+inline GLbitfield barrierBit(Usage usage) {
+    switch (usage) {
+        case Usage::ShaderStorage: return GL_SHADER_STORAGE_BARRIER_BIT;
+        case Usage::Uniform:       return GL_UNIFORM_BARRIER_BIT;
+        case Usage::VertexAttrib:  return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+        case Usage::Command:       return GL_COMMAND_BARRIER_BIT;
+        case Usage::BufferUpdate:  return GL_BUFFER_UPDATE_BARRIER_BIT;
+    }
+    return 0;
+}
+
+// Records which passes read and write which buffers and issues only the barriers
+// a pass actually needs. glMemoryBarrier is global, so a bit emitted for one
+// buffer also clears it for every other buffer written before it.
+//
+// Usage:
+//   barriers.pass("physics", {{src, Usage::ShaderStorage}}, {dst});
+//   physicsShader.dispatch(...);
+class BarrierTracker {
+public:
+    // Debug mode: before each pass, checks every SSBO block the current program
+    // actually uses against the declared reads/writes and reports undeclared or
+    // unsynchronized access.
+    bool validate = false;
+
+    void pass(const char* name,
+              std::initializer_list<std::pair<GLuint, Usage>> reads,
+              std::initializer_list<GLuint> writes = {}) {
+        GLbitfield needed = 0;
+
+        // Read-after-write
+        for (const auto& [buffer, usage] : reads) {
+            auto it = buffers.find(buffer);
+            if (it != buffers.end()) needed |= it->second.pending & barrierBit(usage);
+        }
+        // Write-after-write: the earlier shader write must land first
+        for (GLuint buffer : writes) {
+            auto it = buffers.find(buffer);
+            if (it != buffers.end()) needed |= it->second.pending & GL_SHADER_STORAGE_BARRIER_BIT;
+        }
+
+        if (validate) validatePass(name, reads, writes, needed);
+
+        if (needed) {
+            glMemoryBarrier(needed);
+            barriersEmitted++;
+            for (auto& [buffer, state] : buffers) state.pending &= ~needed;
+            if (validate) {
+                std::cout << "[barrier] " << name << ": 0x" << std::hex << needed << std::dec << "\n";
+            }
+        }
+
+        for (GLuint buffer : writes) {
+            State& state = buffers[buffer];
+            state.pending = ALL_USAGE_BITS;
+            state.writer = name;
+        }
+        passesRecorded++;
+    }
+
+    // CPU-side transfer (upload, map, readback) touching a shader-written buffer.
+    // There is no program involved, so nothing to validate.
+    void host(const char* name, GLuint buffer) {
+        bool saved = validate;
+        validate = false;
+        pass(name, {{buffer, Usage::BufferUpdate}});
+        validate = saved;
+    }
+
+    // Barriers issued / passes seen since the last call
+    std::pair<int, int> takeStats() {
+        std::pair<int, int> stats{ barriersEmitted, passesRecorded };
+        barriersEmitted = 0;
+        passesRecorded = 0;
+        return stats;
+    }
+
+    void forget(GLuint buffer) { buffers.erase(buffer); }
+
+private:
+    static constexpr GLbitfield ALL_USAGE_BITS =
+        GL_SHADER_STORAGE_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+        GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT;
+
+    struct State {
+        GLbitfield pending = 0;  // consumers that would still see stale data
+        std::string writer;      // last pass that wrote it, for diagnostics
+    };
+
+    std::unordered_map<GLuint, State> buffers;
+    int barriersEmitted = 0;
+    int passesRecorded = 0;
+
+    void validatePass(const char* name,
+                      std::initializer_list<std::pair<GLuint, Usage>> reads,
+                      std::initializer_list<GLuint> writes,
+                      GLbitfield needed) {
+        GLint program = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        if (program == 0) return;
+
+        GLint blocks = 0;
+        glGetProgramInterfaceiv(program, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &blocks);
+        for (GLint b = 0; b < blocks; b++) {
+            const GLenum prop = GL_BUFFER_BINDING;
+            GLint binding = 0;
+            glGetProgramResourceiv(program, GL_SHADER_STORAGE_BLOCK, b, 1, &prop, 1, nullptr, &binding);
+
+            GLint bound = 0;
+            glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, binding, &bound);
+            GLuint buffer = static_cast<GLuint>(bound);
+
+            bool declared = false;
+            for (const auto& read : reads) declared |= read.first == buffer;
+            for (GLuint write : writes) declared |= write == buffer;
+            if (!declared) {
+                std::cerr << "[barrier] HAZARD in " << name << ": binding " << binding
+                          << " (buffer " << buffer << ") is used but not declared\n";
+            }
+
+            auto it = buffers.find(buffer);
+            if (it != buffers.end() && (it->second.pending & ~needed & GL_SHADER_STORAGE_BARRIER_BIT)) {
+                std::cerr << "[barrier] HAZARD in " << name << ": binding " << binding
+                          << " reads unsynchronized writes from " << it->second.writer << "\n";
+            }
+        }
+    }
+};
+
+#endif // BARRIER_TRACKER_H
@@ -8,6 +8,11 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "programCache.h"
 
 class BaseShader {
 public:
@@ -23,6 +28,75 @@ public:
         glUseProgram(ID);
     }
 
+    // --- Reloading ---
+    // Source files this program was built from (watched for hot reload)
+    std::vector<std::string> sourcePaths() const {
+        std::vector<std::string> paths;
+        for (const auto& [type, path] : stagePaths) paths.push_back(path);
+        return paths;
+    }
+
+    // Fresh copy of every stage's source, as the constructor would compile it
+    virtual std::vector<ShaderStage> loadStages() const {
+        std::vector<ShaderStage> stages;
+        for (const auto& [type, path] : stagePaths) {
+            stages.push_back({ type, readFile(path), stageLabel(type) });
+        }
+        return stages;
+    }
+
+    // Same, plus the variant those sources build (see ComputeShader), read
+    // together so a concurrent variant switch cannot pair one with the other.
+    // Plain shaders have a single, unnamed variant.
+    virtual std::vector<ShaderStage> loadStages(std::string& variant) const {
+        variant.clear();
+        return loadStages();
+    }
+
+    // Swap in a newly linked program, built for 'variant'; the old one is deleted.
+    // Must be called on the thread that renders with this shader.
+    virtual void replaceProgram(unsigned int program, const std::string& variant) {
+        (void)variant;
+        glDeleteProgram(ID);
+        ID = program;
+    }
+
+    // Compile + link (or fetch from the binary cache). 'ok' reports whether
+    // every stage compiled and the program linked.
+    static unsigned int buildProgram(const std::vector<ShaderStage>& stages, bool* ok) {
+        uint64_t cacheKey = ProgramCache::key(stages);
+        if (unsigned int cached = ProgramCache::load(cacheKey)) {
+            if (ok) *ok = true;
+            return cached;
+        }
+
+        unsigned int program = glCreateProgram();
+        std::vector<unsigned int> shaders;
+        bool success = true;
+        for (const ShaderStage& stage : stages) {
+            const char* code = stage.source.c_str();
+            unsigned int shader = glCreateShader(stage.type);
+            glShaderSource(shader, 1, &code, NULL);
+            glCompileShader(shader);
+            success &= checkCompileErrors(shader, stage.label);
+            glAttachShader(program, shader);
+            shaders.push_back(shader);
+        }
+
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+        success &= checkCompileErrors(program, "PROGRAM");
+
+        for (unsigned int shader : shaders) {
+            glDetachShader(program, shader);
+            glDeleteShader(shader);
+        }
+
+        if (success) ProgramCache::store(cacheKey, program);
+        if (ok) *ok = success;
+        return program;
+    }
+
     // --- Uniform Utility Functions (Common to ALL shaders) ---
     void setBool(const std::string &name, bool value) const {
         glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
@@ -45,6 +119,9 @@ public:
     void setVec3(const std::string &name, const glm::vec3 &value) const {
         glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
     }
+    void setVec4(const std::string &name, const glm::vec4 &value) const {
+        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    }
     void setMat4(const std::string &name, const glm::mat4 &mat) const {
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
@@ -53,8 +130,25 @@ protected:
     // Protected Constructor so you can't instantiate "BaseShader" directly
     BaseShader() : ID(0) {}
 
+    // (stage type, file path) pairs, filled in by the derived constructor
+    std::vector<std::pair<GLenum, std::string>> stagePaths;
+
+    // Build from the files in stagePaths
+    void build() {
+        ID = buildProgram(loadStages(), nullptr);
+    }
+
+    static std::string stageLabel(GLenum type) {
+        switch (type) {
+            case GL_VERTEX_SHADER:   return "VERTEX";
+            case GL_FRAGMENT_SHADER: return "FRAGMENT";
+            case GL_COMPUTE_SHADER:  return "COMPUTE";
+            default:                 return "SHADER";
+        }
+    }
+
     // --- Helper: Read File ---
-    std::string readFile(const std::string& path) {
+    static std::string readFile(const std::string& path) {
         std::ifstream file(path, std::ios::binary);
         if (!file) {
             throw std::runtime_error("Failed to open shader file: " + path);
@@ -73,7 +167,7 @@ protected:
         return source;
     }
     // --- Helper: Check Errors ---
-    void checkCompileErrors(unsigned int shader, std::string type) {
+    static bool checkCompileErrors(unsigned int shader, std::string type) {
         int success;
         char infoLog[1024];
         if (type != "PROGRAM") {
@@ -90,6 +184,7 @@ protected:
                 std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
+        return success;
     }
 };
 
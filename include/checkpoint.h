@@ -0,0 +1,170 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "crc32.h"
+#include "particle.h"
+
+// Everything needed to continue a run from a frame boundary.
+//
+// File layout (host byte order, little-endian on every target we build for):
+//   Header | particles (particleCount * sizeof(Particle)) |
+//   field (fieldWidth * fieldHeight * vec2) | CRC-32 of everything before it
+//
+// save() writes to "<path>.tmp" and renames it over 'path', so being killed
+// mid-write leaves the previous checkpoint intact.
+struct Checkpoint {
+    static constexpr uint32_t VERSION = 1;
+
+    uint64_t frame = 0;
+    double simTime = 0.0;
+    float gravityConstant = 0.0f;
+    bool pushEnabled = true;
+    bool collisionsEnabled = true;
+    bool periodicBoundary = false;
+    bool deterministic = false;
+    uint64_t rngSeed = 0;
+    uint64_t rngStream = 0;
+    uint64_t rngPosition = 0;
+
+    std::vector<Particle> particles;
+    uint32_t fieldWidth = 0;
+    uint32_t fieldHeight = 0;
+    std::vector<glm::vec2> fields;
+
+    bool save(const std::string& path) const {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.flags = (pushEnabled ? PUSH : 0u) | (collisionsEnabled ? COLLISIONS : 0u) |
+                       (periodicBoundary ? PERIODIC : 0u) | (deterministic ? DETERMINISTIC : 0u);
+        header.frame = frame;
+        header.simTime = simTime;
+        header.gravityConstant = gravityConstant;
+        header.particleStride = sizeof(Particle);
+        header.rngSeed = rngSeed;
+        header.rngStream = rngStream;
+        header.rngPosition = rngPosition;
+        header.particleCount = static_cast<uint32_t>(particles.size());
+        header.fieldWidth = fieldWidth;
+        header.fieldHeight = fieldHeight;
+
+        size_t particleBytes = particles.size() * sizeof(Particle);
+        size_t fieldBytes = fields.size() * sizeof(glm::vec2);
+        uint32_t crc = crc32(&header, sizeof(header));
+        crc = crc32(particles.data(), particleBytes, crc);
+        crc = crc32(fields.data(), fieldBytes, crc);
+
+        std::string temp = path + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(particles.data()), particleBytes);
+            out.write(reinterpret_cast<const char*>(fields.data()), fieldBytes);
+            out.write(reinterpret_cast<const char*>(&crc), sizeof(crc));
+            if (!out) {
+                std::cerr << "Checkpoint: could not write " << temp << "\n";
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temp, path, ec);
+        if (ec) {
+            std::cerr << "Checkpoint: could not replace " << path << ": " << ec.message() << "\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            std::cerr << "Checkpoint: could not open " << path << "\n";
+            return false;
+        }
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        Header header;
+        if (bytes.size() < sizeof(header) + sizeof(uint32_t)) return fail(path, "truncated");
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return fail(path, "not a checkpoint");
+        if (header.version != VERSION) {
+            return fail(path, "version " + std::to_string(header.version) + ", expected " + std::to_string(VERSION));
+        }
+        if (header.particleStride != sizeof(Particle)) return fail(path, "particle layout differs from this build");
+
+        size_t particleBytes = static_cast<size_t>(header.particleCount) * sizeof(Particle);
+        size_t fieldBytes = static_cast<size_t>(header.fieldWidth) * header.fieldHeight * sizeof(glm::vec2);
+        size_t payloadEnd = sizeof(header) + particleBytes + fieldBytes;
+        if (bytes.size() != payloadEnd + sizeof(uint32_t)) return fail(path, "size does not match its header");
+
+        uint32_t stored;
+        std::memcpy(&stored, bytes.data() + payloadEnd, sizeof(stored));
+        if (crc32(bytes.data(), payloadEnd) != stored) return fail(path, "checksum mismatch");
+
+        frame = header.frame;
+        simTime = header.simTime;
+        gravityConstant = header.gravityConstant;
+        pushEnabled = (header.flags & PUSH) != 0;
+        collisionsEnabled = (header.flags & COLLISIONS) != 0;
+        periodicBoundary = (header.flags & PERIODIC) != 0;
+        deterministic = (header.flags & DETERMINISTIC) != 0;
+        rngSeed = header.rngSeed;
+        rngStream = header.rngStream;
+        rngPosition = header.rngPosition;
+
+        particles.resize(header.particleCount);
+        std::memcpy(particles.data(), bytes.data() + sizeof(header), particleBytes);
+        fieldWidth = header.fieldWidth;
+        fieldHeight = header.fieldHeight;
+        fields.resize(static_cast<size_t>(fieldWidth) * fieldHeight);
+        std::memcpy(fields.data(), bytes.data() + sizeof(header) + particleBytes, fieldBytes);
+        return true;
+    }
+
+private:
+    static constexpr char MAGIC[8] = { 'F', 'L', 'U', 'I', 'D', 'C', 'K', 'P' };
+
+    enum Flags : uint32_t {
+        PUSH = 1u << 0,
+        COLLISIONS = 1u << 1,
+        PERIODIC = 1u << 2,
+        DETERMINISTIC = 1u << 3,
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t flags;
+        uint64_t frame;
+        double simTime;
+        float gravityConstant;
+        uint32_t particleStride; // sizeof(Particle) of the writer
+        uint64_t rngSeed;
+        uint64_t rngStream;
+        uint64_t rngPosition;
+        uint32_t particleCount;
+        uint32_t fieldWidth;
+        uint32_t fieldHeight;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Header) == 80, "Checkpoint header layout is part of the file format");
+
+    static bool fail(const std::string& path, const std::string& reason) {
+        std::cerr << "Checkpoint: " << path << ": " << reason << "\n";
+        return false;
+    }
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,176 @@
+#ifndef COMPUTE_SHADER_H
+#define COMPUTE_SHADER_H
+
+#include "baseShader.h"
+
+#include <map>
+#include <mutex>
+#include <set>
+
+class ComputeShader : public BaseShader {
+public:
+    // Compile-time specialization: each entry becomes "#define NAME VALUE" right
+    // after the #version line, so the compiler can fold constants and strip
+    // disabled features. Every distinct set is built once and kept.
+    using Defines = std::map<std::string, std::string>;
+
+    ComputeShader(const char* computePath, Defines defines = {}) : activeDefines(std::move(defines)) {
+        stagePaths = { { GL_COMPUTE_SHADER, computePath } };
+        // Cached binary if available, otherwise compile + link
+        build();
+        activeKey = variantKey(activeDefines);
+        variants[activeKey] = ID;
+        queryWorkgroupSize();
+    }
+
+    ~ComputeShader() override {
+        for (const auto& [key, program] : variants) {
+            if (program != ID) glDeleteProgram(program);
+        }
+    }
+
+    // Switch to the variant for 'defines', building it on first use. A variant
+    // that fails to build is not cached or switched to: the current one stays
+    // active and false is returned (again without recompiling until the
+    // sources change).
+    bool setDefines(const Defines& defines) {
+        std::string key = variantKey(defines);
+        if (key == activeKey) return true;
+        if (failed.count(key)) return false;
+
+        unsigned int program;
+        auto it = variants.find(key);
+        if (it != variants.end()) {
+            program = it->second;
+        } else {
+            bool ok = false;
+            program = buildProgram(stagesFor(defines), &ok);
+            if (!ok) {
+                glDeleteProgram(program);
+                failed.insert(key);
+                return false;
+            }
+            variants[key] = program;
+        }
+        {
+            std::lock_guard<std::mutex> lock(definesMutex);
+            activeDefines = defines;
+        }
+        activeKey = key;
+        ID = program;
+        queryWorkgroupSize();
+        return true;
+    }
+
+    // Convenience for single-value changes, e.g. setDefine("ENABLE_PUSH", "0")
+    bool setDefine(const std::string& name, const std::string& value) {
+        Defines defines = this->defines();
+        defines[name] = value;
+        return setDefines(defines);
+    }
+
+    Defines defines() const {
+        std::lock_guard<std::mutex> lock(definesMutex);
+        return activeDefines;
+    }
+
+    std::vector<ShaderStage> loadStages() const override {
+        return stagesFor(defines());
+    }
+
+    std::vector<ShaderStage> loadStages(std::string& variant) const override {
+        Defines defines = this->defines();
+        variant = variantKey(defines);
+        return stagesFor(defines);
+    }
+
+    // A hot reload invalidates every other variant; they rebuild lazily. The
+    // reload worker built 'program' from the defines active when it started:
+    // if the render thread has switched variant since, the program is kept for
+    // the variant it was built for and the active one is rebuilt here.
+    void replaceProgram(unsigned int program, const std::string& variant) override {
+        for (const auto& [key, cached] : variants) {
+            if (cached != ID) glDeleteProgram(cached);
+        }
+        variants.clear();
+        failed.clear();
+
+        if (variant == activeKey) {
+            BaseShader::replaceProgram(program, variant);
+        } else {
+            variants[variant] = program;
+            bool ok = false;
+            unsigned int rebuilt = buildProgram(loadStages(), &ok);
+            if (ok) BaseShader::replaceProgram(rebuilt, activeKey);
+            else glDeleteProgram(rebuilt); // Keep the previous build of the active variant
+        }
+        variants[activeKey] = ID;
+        queryWorkgroupSize();
+    }
+
+    // local_size_x of the active variant, as linked
+    unsigned int workgroupSize() const { return localSizeX; }
+
+    // Helper specifically for Compute Shaders
+    void dispatch(unsigned int x, unsigned int y, unsigned int z) {
+        glDispatchCompute(x, y, z);
+    }
+
+    // One invocation per item, rounded up to whole workgroups
+    void dispatch1D(unsigned int items) {
+        if (items == 0) return;
+        glDispatchCompute((items + localSizeX - 1) / localSizeX, 1, 1);
+    }
+
+    void memoryBarrier(GLbitfield barriers) {
+        glMemoryBarrier(barriers);
+    }
+
+private:
+    Defines activeDefines;
+    mutable std::mutex definesMutex; // loadStages() also runs on the reload thread
+    std::string activeKey;
+    std::map<std::string, unsigned int> variants;
+    std::set<std::string> failed; // Variants that did not build from the current sources
+    unsigned int localSizeX = 1;
+
+    std::vector<ShaderStage> stagesFor(const Defines& defines) const {
+        std::vector<ShaderStage> stages = BaseShader::loadStages();
+        for (ShaderStage& stage : stages) stage.source = injectDefines(stage.source, defines);
+        return stages;
+    }
+
+    static std::string variantKey(const Defines& defines) {
+        std::string key;
+        for (const auto& [name, value] : defines) key += name + "=" + value + ";";
+        return key;
+    }
+
+    static std::string injectDefines(const std::string& source, const Defines& defines) {
+        if (defines.empty()) return source;
+
+        std::string block;
+        for (const auto& [name, value] : defines) block += "#define " + name + " " + value + "\n";
+
+        // #version must stay the first statement
+        size_t versionPos = source.find("#version");
+        if (versionPos == std::string::npos) return block + source;
+        size_t lineEnd = source.find('\n', versionPos);
+        if (lineEnd == std::string::npos) return source + "\n" + block;
+
+        int versionLine = 1;
+        for (size_t i = 0; i < lineEnd; i++) versionLine += source[i] == '\n';
+
+        // #line keeps compiler error line numbers matching the file on disk
+        return source.substr(0, lineEnd + 1) + block + "#line " + std::to_string(versionLine + 1) + "\n" +
+               source.substr(lineEnd + 1);
+    }
+
+    void queryWorkgroupSize() {
+        GLint size[3] = { 1, 1, 1 };
+        glGetProgramiv(ID, GL_COMPUTE_WORK_GROUP_SIZE, size);
+        localSizeX = size[0] > 0 ? static_cast<unsigned int>(size[0]) : 1;
+    }
+};
+
+#endif // COMPUTE_SHADER_H
@@ -0,0 +1,516 @@
+#ifndef CPU_KERNELS_H
+#define CPU_KERNELS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPU_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define CPU_KERNELS_X86 0
+#endif
+
+// Per-function ISA selection, so the rest of the build stays at the baseline
+#if defined(__GNUC__) || defined(__clang__)
+#define CPU_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CPU_TARGET(isa)
+#endif
+
+// Exact mode needs each pair term rounded identically by every kernel, so the
+// compiler must not fuse multiply-adds in here (the AVX2 set is built without
+// FMA for the same reason)
+#if defined(__clang__)
+#pragma float_control(precise, on, push)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// Neighbour loops of physics.comp (calculatePush, resolveCollisions) for the
+// CPU path, over structure-of-arrays input. Each kernel folds the range
+// [begin, end) of candidates into one particle's accumulators. The range must
+// not contain the particle itself (callers split around it). The SIMD
+// versions take 4 (SSE2) or 8 (AVX2) candidates per iteration and finish the
+// tail with the scalar loop.
+//
+// All kernels evaluate a pair term with the same operations in the same
+// order, so in exact mode (see Delta) every ISA produces identical bits.
+namespace cpu_kernels {
+
+// Jacobi input state of every particle
+struct Neighbours {
+    const float* x;
+    const float* y;
+    const float* vx;
+    const float* vy;
+    const float* radius;
+    const float* mass;
+    const int32_t* species; // 0..3, indexes the pair rows
+};
+
+// The particle whose neighbours are being visited
+struct Body {
+    float x, y;
+    float vx, vy;
+    float radius;
+    float mass;
+};
+
+struct Constants {
+    float dt;
+    float smoothingRadius;
+    float slop;  // COLLISION_SLOP
+    float beta;  // BAUMGARTE_BETA
+    float width;
+    float height;
+    bool periodic;
+};
+
+// Accumulators; applied by the caller after the whole neighbour range.
+//
+// In exact mode each pair term is rounded to 32.32 fixed point and summed as
+// an integer instead, so the total no longer depends on summation order (lane
+// width, tail split, range order). resolve() converts the sums back.
+struct Delta {
+    float px = 0.0f, py = 0.0f;
+    float vx = 0.0f, vy = 0.0f;
+
+    bool exact = false;
+    int64_t fixed[4] = { 0, 0, 0, 0 };
+
+    static constexpr double FIXED_ONE = 4294967296.0; // 2^32
+    static constexpr double FIXED_LIMIT = 2147483647.0; // Keeps the sum far from overflow
+
+    static int64_t toFixed(float v) {
+        return std::llrint(std::clamp(static_cast<double>(v), -FIXED_LIMIT, FIXED_LIMIT) * FIXED_ONE);
+    }
+
+    void addExact(float dpx, float dpy, float dvx, float dvy) {
+        fixed[0] += toFixed(dpx);
+        fixed[1] += toFixed(dpy);
+        fixed[2] += toFixed(dvx);
+        fixed[3] += toFixed(dvy);
+    }
+
+    void resolve() {
+        if (!exact) return;
+        px = static_cast<float>(static_cast<double>(fixed[0]) / FIXED_ONE);
+        py = static_cast<float>(static_cast<double>(fixed[1]) / FIXED_ONE);
+        vx = static_cast<float>(static_cast<double>(fixed[2]) / FIXED_ONE);
+        vy = static_cast<float>(static_cast<double>(fixed[3]) / FIXED_ONE);
+    }
+};
+
+// pushRow / restitutionRow: this particle's row of the species pair table
+using PushFn = void (*)(const Neighbours&, uint32_t begin, uint32_t end, const Body&,
+                        const float pushRow[4], const Constants&, Delta&);
+using CollideFn = void (*)(const Neighbours&, uint32_t begin, uint32_t end, const Body&,
+                           const float restitutionRow[4], const Constants&, Delta&);
+
+enum class Isa { Scalar, SSE2, AVX2 };
+
+inline const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2:   return "sse2";
+        case Isa::AVX2:   return "avx2";
+    }
+    return "?";
+}
+
+// ---------------------------------------------------------
+// Scalar (reference)
+// ---------------------------------------------------------
+inline float minimumImage(float d, float extent, bool periodic) {
+    return periodic ? d - extent * std::nearbyint(d * (1.0f / extent)) : d;
+}
+
+inline void pushScalar(const Neighbours& n, uint32_t begin, uint32_t end, const Body& b,
+                       const float pushRow[4], const Constants& c, Delta& out) {
+    float hSq = c.smoothingRadius * c.smoothingRadius;
+    for (uint32_t j = begin; j < end; j++) {
+        float dx = minimumImage(n.x[j] - b.x, c.width, c.periodic);
+        float dy = minimumImage(n.y[j] - b.y, c.height, c.periodic);
+        float distSq = dx * dx + dy * dy;
+        if (distSq >= hSq || distSq < 1e-6f) continue;
+
+        float dist = std::sqrt(distSq);
+        float x = c.smoothingRadius - dist;
+        float force = pushRow[n.species[j]] * (x * x) * c.dt / dist;
+        float tx = dx * force;
+        float ty = dy * force;
+        if (out.exact) {
+            out.addExact(0.0f, 0.0f, -tx, -ty);
+        } else {
+            out.vx -= tx;
+            out.vy -= ty;
+        }
+    }
+}
+
+inline void collideScalar(const Neighbours& n, uint32_t begin, uint32_t end, const Body& b,
+                          const float restitutionRow[4], const Constants& c, Delta& out) {
+    float biasScale = -c.beta / c.dt;
+    for (uint32_t j = begin; j < end; j++) {
+        float dx = minimumImage(b.x - n.x[j], c.width, c.periodic);
+        float dy = minimumImage(b.y - n.y[j], c.height, c.periodic);
+        float distSq = dx * dx + dy * dy;
+        float combinedR = b.radius + n.radius[j];
+        if (distSq >= combinedR * combinedR || distSq < 1e-8f) continue;
+
+        float dist = std::sqrt(distSq);
+        float nx = dx / dist;
+        float ny = dy / dist;
+        float depth = std::max(0.0f, combinedR - dist - c.slop);
+        float share = n.mass[j] / (b.mass + n.mass[j]);
+
+        float corr = depth * share;
+        float tpx = nx * corr;
+        float tpy = ny * corr;
+        float tvx = 0.0f;
+        float tvy = 0.0f;
+
+        float vRel = (b.vx - n.vx[j]) * nx + (b.vy - n.vy[j]) * ny;
+        if (vRel < 0.0f) {
+            float bias = biasScale * depth;
+            float dv = (0.0f - ((1.0f + restitutionRow[n.species[j]]) * vRel + bias)) * share;
+            tvx = dv * nx;
+            tvy = dv * ny;
+        }
+
+        if (out.exact) {
+            out.addExact(tpx, tpy, tvx, tvy);
+        } else {
+            out.px += tpx;
+            out.py += tpy;
+            out.vx += tvx;
+            out.vy += tvy;
+        }
+    }
+}
+
+#if CPU_KERNELS_X86
+// ---------------------------------------------------------
+// SSE2 (4 candidates per iteration, baseline on x86-64)
+// ---------------------------------------------------------
+CPU_TARGET("sse2") inline float hsum128(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+// Round-to-nearest through the integer conversion (SSE2 has no roundps)
+CPU_TARGET("sse2") inline __m128 minimumImage128(__m128 d, __m128 extent, __m128 invExtent, bool periodic) {
+    if (!periodic) return d;
+    __m128 wraps = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(d, invExtent)));
+    return _mm_sub_ps(d, _mm_mul_ps(extent, wraps));
+}
+
+CPU_TARGET("sse2") inline __m128 gatherRow128(const float row[4], const int32_t* species) {
+    return _mm_setr_ps(row[species[0]], row[species[1]], row[species[2]], row[species[3]]);
+}
+
+CPU_TARGET("sse2") inline void pushSSE2(const Neighbours& n, uint32_t begin, uint32_t end, const Body& b,
+                                        const float pushRow[4], const Constants& c, Delta& out) {
+    const __m128 bx = _mm_set1_ps(b.x), by = _mm_set1_ps(b.y);
+    const __m128 h = _mm_set1_ps(c.smoothingRadius), hSq = _mm_set1_ps(c.smoothingRadius * c.smoothingRadius);
+    const __m128 minSq = _mm_set1_ps(1e-6f), dt = _mm_set1_ps(c.dt);
+    const __m128 w = _mm_set1_ps(c.width), invW = _mm_set1_ps(1.0f / c.width);
+    const __m128 hgt = _mm_set1_ps(c.height), invH = _mm_set1_ps(1.0f / c.height);
+    __m128 accX = _mm_setzero_ps(), accY = _mm_setzero_ps();
+
+    uint32_t j = begin;
+    for (; j + 4 <= end; j += 4) {
+        __m128 dx = minimumImage128(_mm_sub_ps(_mm_loadu_ps(n.x + j), bx), w, invW, c.periodic);
+        __m128 dy = minimumImage128(_mm_sub_ps(_mm_loadu_ps(n.y + j), by), hgt, invH, c.periodic);
+        __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 mask = _mm_and_ps(_mm_cmplt_ps(distSq, hSq), _mm_cmpge_ps(distSq, minSq));
+        if (_mm_movemask_ps(mask) == 0) continue;
+
+        __m128 dist = _mm_sqrt_ps(distSq);
+        __m128 x = _mm_sub_ps(h, dist);
+        __m128 force = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(gatherRow128(pushRow, n.species + j), _mm_mul_ps(x, x)), dt), dist);
+        force = _mm_and_ps(force, mask); // Masked lanes may hold inf/NaN
+        __m128 tx = _mm_mul_ps(dx, force);
+        __m128 ty = _mm_mul_ps(dy, force);
+        if (out.exact) {
+            alignas(16) float lx[4], ly[4];
+            _mm_store_ps(lx, tx);
+            _mm_store_ps(ly, ty);
+            for (int k = 0; k < 4; k++) out.addExact(0.0f, 0.0f, -lx[k], -ly[k]);
+            continue;
+        }
+        accX = _mm_add_ps(accX, tx);
+        accY = _mm_add_ps(accY, ty);
+    }
+    out.vx -= hsum128(accX);
+    out.vy -= hsum128(accY);
+    pushScalar(n, j, end, b, pushRow, c, out);
+}
+
+CPU_TARGET("sse2") inline void collideSSE2(const Neighbours& n, uint32_t begin, uint32_t end, const Body& b,
+                                           const float restitutionRow[4], const Constants& c, Delta& out) {
+    const __m128 bx = _mm_set1_ps(b.x), by = _mm_set1_ps(b.y);
+    const __m128 bvx = _mm_set1_ps(b.vx), bvy = _mm_set1_ps(b.vy);
+    const __m128 br = _mm_set1_ps(b.radius), bm = _mm_set1_ps(b.mass);
+    const __m128 minSq = _mm_set1_ps(1e-8f), slop = _mm_set1_ps(c.slop);
+    const __m128 biasScale = _mm_set1_ps(-c.beta / c.dt), one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+    const __m128 w = _mm_set1_ps(c.width), invW = _mm_set1_ps(1.0f / c.width);
+    const __m128 hgt = _mm_set1_ps(c.height), invH = _mm_set1_ps(1.0f / c.height);
+    __m128 accPx = zero, accPy = zero, accVx = zero, accVy = zero;
+
+    uint32_t j = begin;
+    for (; j + 4 <= end; j += 4) {
+        __m128 dx = minimumImage128(_mm_sub_ps(bx, _mm_loadu_ps(n.x + j)), w, invW, c.periodic);
+        __m128 dy = minimumImage128(_mm_sub_ps(by, _mm_loadu_ps(n.y + j)), hgt, invH, c.periodic);
+        __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 combinedR = _mm_add_ps(br, _mm_loadu_ps(n.radius + j));
+        __m128 mask = _mm_and_ps(_mm_cmplt_ps(distSq, _mm_mul_ps(combinedR, combinedR)), _mm_cmpge_ps(distSq, minSq));
+        if (_mm_movemask_ps(mask) == 0) continue;
+
+        __m128 dist = _mm_sqrt_ps(distSq);
+        __m128 nx = _mm_div_ps(dx, dist);
+        __m128 ny = _mm_div_ps(dy, dist);
+        __m128 depth = _mm_max_ps(zero, _mm_sub_ps(_mm_sub_ps(combinedR, dist), slop));
+        __m128 otherMass = _mm_loadu_ps(n.mass + j);
+        __m128 share = _mm_and_ps(_mm_div_ps(otherMass, _mm_add_ps(bm, otherMass)), mask);
+
+        __m128 corr = _mm_mul_ps(depth, share);
+
+        __m128 vRel = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(bvx, _mm_loadu_ps(n.vx + j)), nx),
+                                 _mm_mul_ps(_mm_sub_ps(bvy, _mm_loadu_ps(n.vy + j)), ny));
+        __m128 approaching = _mm_and_ps(mask, _mm_cmplt_ps(vRel, zero));
+        __m128 restitution = gatherRow128(restitutionRow, n.species + j);
+        __m128 bias = _mm_mul_ps(biasScale, depth);
+        __m128 dv = _mm_mul_ps(_mm_sub_ps(zero, _mm_add_ps(_mm_mul_ps(_mm_add_ps(one, restitution), vRel), bias)), share);
+        dv = _mm_and_ps(dv, approaching);
+        __m128 tpx = _mm_and_ps(_mm_mul_ps(nx, corr), mask);
+        __m128 tpy = _mm_and_ps(_mm_mul_ps(ny, corr), mask);
+        __m128 tvx = _mm_and_ps(_mm_mul_ps(dv, nx), approaching);
+        __m128 tvy = _mm_and_ps(_mm_mul_ps(dv, ny), approaching);
+        if (out.exact) {
+            alignas(16) float lpx[4], lpy[4], lvx[4], lvy[4];
+            _mm_store_ps(lpx, tpx);
+            _mm_store_ps(lpy, tpy);
+            _mm_store_ps(lvx, tvx);
+            _mm_store_ps(lvy, tvy);
+            for (int k = 0; k < 4; k++) out.addExact(lpx[k], lpy[k], lvx[k], lvy[k]);
+            continue;
+        }
+        accPx = _mm_add_ps(accPx, tpx);
+        accPy = _mm_add_ps(accPy, tpy);
+        accVx = _mm_add_ps(accVx, tvx);
+        accVy = _mm_add_ps(accVy, tvy);
+    }
+    out.px += hsum128(accPx);
+    out.py += hsum128(accPy);
+    out.vx += hsum128(accVx);
+    out.vy += hsum128(accVy);
+    collideScalar(n, j, end, b, restitutionRow, c, out);
+}
+
+// ---------------------------------------------------------
+// AVX2 (8 candidates per iteration)
+// ---------------------------------------------------------
+CPU_TARGET("avx2") inline float hsum256(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    __m128 shuf = _mm_movehdup_ps(sum);
+    __m128 sums = _mm_add_ps(sum, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+CPU_TARGET("avx2") inline __m256 minimumImage256(__m256 d, __m256 extent, __m256 invExtent, bool periodic) {
+    if (!periodic) return d;
+    __m256 wraps = _mm256_round_ps(_mm256_mul_ps(d, invExtent), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    return _mm256_sub_ps(d, _mm256_mul_ps(extent, wraps));
+}
+
+// Species ids are 0..3, so a 4-entry row broadcast to both halves is looked up
+// with one in-lane permute instead of a gather
+CPU_TARGET("avx2") inline __m256 lookupRow256(__m256 row, const int32_t* species) {
+    return _mm256_permutevar_ps(row, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(species)));
+}
+
+CPU_TARGET("avx2") inline void pushAVX2(const Neighbours& n, uint32_t begin, uint32_t end, const Body& b,
+                                            const float pushRow[4], const Constants& c, Delta& out) {
+    const __m256 bx = _mm256_set1_ps(b.x), by = _mm256_set1_ps(b.y);
+    const __m256 h = _mm256_set1_ps(c.smoothingRadius), hSq = _mm256_set1_ps(c.smoothingRadius * c.smoothingRadius);
+    const __m256 minSq = _mm256_set1_ps(1e-6f), dt = _mm256_set1_ps(c.dt);
+    const __m256 w = _mm256_set1_ps(c.width), invW = _mm256_set1_ps(1.0f / c.width);
+    const __m256 hgt = _mm256_set1_ps(c.height), invH = _mm256_set1_ps(1.0f / c.height);
+    const __m256 row = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(pushRow));
+    __m256 accX = _mm256_setzero_ps(), accY = _mm256_setzero_ps();
+
+    uint32_t j = begin;
+    for (; j + 8 <= end; j += 8) {
+        __m256 dx = minimumImage256(_mm256_sub_ps(_mm256_loadu_ps(n.x + j), bx), w, invW, c.periodic);
+        __m256 dy = minimumImage256(_mm256_sub_ps(_mm256_loadu_ps(n.y + j), by), hgt, invH, c.periodic);
+        __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 mask = _mm256_and_ps(_mm256_cmp_ps(distSq, hSq, _CMP_LT_OQ), _mm256_cmp_ps(distSq, minSq, _CMP_GE_OQ));
+        if (_mm256_movemask_ps(mask) == 0) continue;
+
+        __m256 dist = _mm256_sqrt_ps(distSq);
+        __m256 x = _mm256_sub_ps(h, dist);
+        __m256 force = _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(lookupRow256(row, n.species + j), _mm256_mul_ps(x, x)), dt), dist);
+        force = _mm256_and_ps(force, mask); // Masked lanes may hold inf/NaN
+        __m256 tx = _mm256_mul_ps(dx, force);
+        __m256 ty = _mm256_mul_ps(dy, force);
+        if (out.exact) {
+            alignas(32) float lx[8], ly[8];
+            _mm256_store_ps(lx, tx);
+            _mm256_store_ps(ly, ty);
+            for (int k = 0; k < 8; k++) out.addExact(0.0f, 0.0f, -lx[k], -ly[k]);
+            continue;
+        }
+        accX = _mm256_add_ps(accX, tx);
+        accY = _mm256_add_ps(accY, ty);
+    }
+    out.vx -= hsum256(accX);
+    out.vy -= hsum256(accY);
+    pushScalar(n, j, end, b, pushRow, c, out);
+}
+
+CPU_TARGET("avx2") inline void collideAVX2(const Neighbours& n, uint32_t begin, uint32_t end, const Body& b,
+                                               const float restitutionRow[4], const Constants& c, Delta& out) {
+    const __m256 bx = _mm256_set1_ps(b.x), by = _mm256_set1_ps(b.y);
+    const __m256 bvx = _mm256_set1_ps(b.vx), bvy = _mm256_set1_ps(b.vy);
+    const __m256 br = _mm256_set1_ps(b.radius), bm = _mm256_set1_ps(b.mass);
+    const __m256 minSq = _mm256_set1_ps(1e-8f), slop = _mm256_set1_ps(c.slop);
+    const __m256 biasScale = _mm256_set1_ps(-c.beta / c.dt), one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+    const __m256 w = _mm256_set1_ps(c.width), invW = _mm256_set1_ps(1.0f / c.width);
+    const __m256 hgt = _mm256_set1_ps(c.height), invH = _mm256_set1_ps(1.0f / c.height);
+    const __m256 row = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(restitutionRow));
+    __m256 accPx = zero, accPy = zero, accVx = zero, accVy = zero;
+
+    uint32_t j = begin;
+    for (; j + 8 <= end; j += 8) {
+        __m256 dx = minimumImage256(_mm256_sub_ps(bx, _mm256_loadu_ps(n.x + j)), w, invW, c.periodic);
+        __m256 dy = minimumImage256(_mm256_sub_ps(by, _mm256_loadu_ps(n.y + j)), hgt, invH, c.periodic);
+        __m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 combinedR = _mm256_add_ps(br, _mm256_loadu_ps(n.radius + j));
+        __m256 mask = _mm256_and_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(combinedR, combinedR), _CMP_LT_OQ),
+                                    _mm256_cmp_ps(distSq, minSq, _CMP_GE_OQ));
+        if (_mm256_movemask_ps(mask) == 0) continue;
+
+        __m256 dist = _mm256_sqrt_ps(distSq);
+        __m256 nx = _mm256_div_ps(dx, dist);
+        __m256 ny = _mm256_div_ps(dy, dist);
+        __m256 depth = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_sub_ps(combinedR, dist), slop));
+        __m256 otherMass = _mm256_loadu_ps(n.mass + j);
+        __m256 share = _mm256_and_ps(_mm256_div_ps(otherMass, _mm256_add_ps(bm, otherMass)), mask);
+
+        __m256 corr = _mm256_mul_ps(depth, share);
+
+        __m256 vRel = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(bvx, _mm256_loadu_ps(n.vx + j)), nx),
+                                    _mm256_mul_ps(_mm256_sub_ps(bvy, _mm256_loadu_ps(n.vy + j)), ny));
+        __m256 approaching = _mm256_and_ps(mask, _mm256_cmp_ps(vRel, zero, _CMP_LT_OQ));
+        __m256 restitution = lookupRow256(row, n.species + j);
+        __m256 bias = _mm256_mul_ps(biasScale, depth);
+        __m256 dv = _mm256_mul_ps(_mm256_sub_ps(zero, _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(one, restitution), vRel), bias)), share);
+        dv = _mm256_and_ps(dv, approaching);
+        __m256 tpx = _mm256_and_ps(_mm256_mul_ps(nx, corr), mask);
+        __m256 tpy = _mm256_and_ps(_mm256_mul_ps(ny, corr), mask);
+        __m256 tvx = _mm256_and_ps(_mm256_mul_ps(dv, nx), approaching);
+        __m256 tvy = _mm256_and_ps(_mm256_mul_ps(dv, ny), approaching);
+        if (out.exact) {
+            alignas(32) float lpx[8], lpy[8], lvx[8], lvy[8];
+            _mm256_store_ps(lpx, tpx);
+            _mm256_store_ps(lpy, tpy);
+            _mm256_store_ps(lvx, tvx);
+            _mm256_store_ps(lvy, tvy);
+            for (int k = 0; k < 8; k++) out.addExact(lpx[k], lpy[k], lvx[k], lvy[k]);
+            continue;
+        }
+        accPx = _mm256_add_ps(accPx, tpx);
+        accPy = _mm256_add_ps(accPy, tpy);
+        accVx = _mm256_add_ps(accVx, tvx);
+        accVy = _mm256_add_ps(accVy, tvy);
+    }
+    out.px += hsum256(accPx);
+    out.py += hsum256(accPy);
+    out.vx += hsum256(accVx);
+    out.vy += hsum256(accVy);
+    collideScalar(n, j, end, b, restitutionRow, c, out);
+}
+#endif // CPU_KERNELS_X86
+
+// ---------------------------------------------------------
+// Runtime dispatch
+// ---------------------------------------------------------
+// Best ISA this CPU and OS support (AVX2 also needs the OS to save YMM state)
+inline Isa detectIsa() {
+#if CPU_KERNELS_X86
+    unsigned int regs[4] = { 0, 0, 0, 0 };
+    auto cpuid = [&](unsigned int leaf, unsigned int subleaf) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int r[4];
+        __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; i++) regs[i] = static_cast<unsigned int>(r[i]);
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    };
+
+    cpuid(0, 0);
+    unsigned int maxLeaf = regs[0];
+    cpuid(1, 0);
+    bool sse2 = (regs[3] >> 26) & 1;
+    bool osxsave = (regs[2] >> 27) & 1;
+    bool avx = (regs[2] >> 28) & 1;
+
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx) {
+        cpuid(7, 0);
+        bool avx2Bit = (regs[1] >> 5) & 1;
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long long xcr0 = _xgetbv(0);
+#else
+        unsigned int xcrLow, xcrHigh;
+        __asm__ volatile("xgetbv" : "=a"(xcrLow), "=d"(xcrHigh) : "c"(0));
+        unsigned long long xcr0 = (static_cast<unsigned long long>(xcrHigh) << 32) | xcrLow;
+#endif
+        avx2 = avx2Bit && (xcr0 & 0x6) == 0x6; // XMM and YMM state enabled
+    }
+
+    if (avx2) return Isa::AVX2;
+    if (sse2) return Isa::SSE2;
+#endif
+    return Isa::Scalar;
+}
+
+struct KernelSet {
+    Isa isa;
+    PushFn push;
+    CollideFn collide;
+};
+
+// Kernels for 'isa', falling back to the best one below it that is compiled in
+inline KernelSet kernels(Isa isa) {
+#if CPU_KERNELS_X86
+    if (isa == Isa::AVX2) return { Isa::AVX2, pushAVX2, collideAVX2 };
+    if (isa == Isa::SSE2) return { Isa::SSE2, pushSSE2, collideSSE2 };
+#else
+    (void)isa;
+#endif
+    return { Isa::Scalar, pushScalar, collideScalar };
+}
+
+} // namespace cpu_kernels
+
+#if defined(__clang__)
+#pragma float_control(pop)
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // CPU_KERNELS_H
@@ -0,0 +1,469 @@
+#ifndef CPU_PHYSICS_H
+#define CPU_PHYSICS_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "cpuKernels.h"
+#include "obstacles.h"
+#include "particle.h"
+#include "species.h"
+#include "workStealingPool.h"
+
+// Feature switches and uniforms of physics.comp
+struct CpuPhysicsParams {
+    float gravity = 0.0f;
+    glm::vec2 dimensions = glm::vec2(800.0f, 600.0f);
+    float smoothingRadius = 100.0f;
+    float slop = 0.001f;  // COLLISION_SLOP
+    float beta = 0.2f;    // BAUMGARTE_BETA
+    bool push = true;
+    bool collisions = true;
+    bool periodic = false;
+};
+
+// physics.comp on the CPU, for headless jobs. State is kept as structure of
+// arrays so the neighbour kernels (cpuKernels.h) stream through contiguous
+// floats; the best kernel set for this CPU is picked once at construction.
+//
+// Each substep is a small pipeline:
+//   1. bin:  counting sort of every particle into a uniform grid whose cells
+//            are at least one interaction radius wide (state is reordered, so
+//            each cell is a contiguous range)
+//   2. step: per-cell tasks run push -> integrate -> contacts -> boundaries
+//            over the 3x3 neighbouring cells
+//   3. swap
+// computeField() mirrors gravity.comp on the same bins. With a
+// WorkStealingPool, the per-cell and per-row work is split across its threads
+// and stealing evens out crowded cells.
+//
+// Like the shader, a step is Jacobi: every particle reads the previous state
+// and writes the next. One difference: contacts are accumulated against the
+// particle's state before any contact is applied, instead of one after another,
+// so the candidates of a SIMD batch are independent of each other.
+//
+// With setDeterministic(true) the neighbour sums are order-independent (see
+// cpu_kernels::Delta), so results are bit-identical across kernel sets and
+// thread counts.
+class CpuPhysics {
+public:
+    using Isa = cpu_kernels::Isa;
+
+    static constexpr float SOFTENING = 10.0f; // gravity.comp
+
+    CpuPhysics(const SpeciesTable& species, const ObstacleField* obstacles = nullptr,
+               WorkStealingPool* pool = nullptr)
+        : table(species.block()), speciesCount(species.count()),
+          obstacles(obstacles && !obstacles->empty() ? obstacles : nullptr), pool(pool),
+          active(cpu_kernels::kernels(cpu_kernels::detectIsa())) {}
+
+    // Force a kernel set, e.g. to compare ISAs. Never above what this CPU runs
+    // (detectIsa()) or what is compiled in; false if it had to fall back.
+    bool setIsa(Isa isa) {
+        active = cpu_kernels::kernels(std::min(isa, cpu_kernels::detectIsa()));
+        return active.isa == isa;
+    }
+    Isa isa() const { return active.isa; }
+
+    void setDeterministic(bool enabled) { deterministic = enabled; }
+    bool isDeterministic() const { return deterministic; }
+
+    void load(const std::vector<Particle>& particles) {
+        size_t n = particles.size();
+        state.resize(n);
+        next.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            const Particle& p = particles[i];
+            state.x[i] = p.pos_radius.x;
+            state.y[i] = p.pos_radius.y;
+            state.z[i] = p.pos_radius.z;
+            state.vx[i] = p.velocity.x;
+            state.vy[i] = p.velocity.y;
+            state.radius[i] = p.pos_radius.w;
+            state.species[i] = speciesOf(p.velocity.w);
+            state.color[i] = p.color;
+            state.id[i] = static_cast<uint32_t>(i);
+        }
+        updateMasses();
+    }
+
+    // Particles come back in the order they were loaded, whatever the binning
+    // did to them, so consecutive stores line up particle for particle
+    void store(std::vector<Particle>& particles) const {
+        particles.resize(size());
+        for (size_t i = 0; i < size(); i++) {
+            Particle& p = particles[state.id[i]];
+            p.pos_radius = glm::vec4(state.x[i], state.y[i], state.z[i], state.radius[i]);
+            p.velocity = glm::vec4(state.vx[i], state.vy[i], 0.0f, static_cast<float>(state.species[i]));
+            p.color = state.color[i];
+        }
+    }
+
+    size_t size() const { return state.x.size(); }
+
+    // One substep over every particle
+    void step(float deltaTime, const CpuPhysicsParams& params) {
+        float dt = std::min(deltaTime, 0.016f); // Same cap as the shader
+        bin(params);
+
+        cpu_kernels::Constants constants{ dt, params.smoothingRadius, params.slop, params.beta,
+                                          params.dimensions.x, params.dimensions.y, params.periodic };
+        forRange(0, static_cast<uint32_t>(cellsX * cellsY), 1, [&](uint32_t first, uint32_t last) {
+            for (uint32_t cell = first; cell < last; cell++) {
+                stepParticles(cellStart[cell], cellStart[cell + 1], constants, params);
+            }
+        });
+
+        std::swap(state.x, next.x);
+        std::swap(state.y, next.y);
+        std::swap(state.vx, next.vx);
+        std::swap(state.vy, next.vy);
+    }
+
+    // gravity.comp (poly6 kernel) into a dimensions.x * dimensions.y grid,
+    // using the bins of the last step
+    void computeField(float gravityConstant, const CpuPhysicsParams& params, std::vector<glm::vec2>& field) {
+        if (cellStart.empty()) bin(params);
+        int width = static_cast<int>(params.dimensions.x);
+        int height = static_cast<int>(params.dimensions.y);
+        field.assign(static_cast<size_t>(width) * height, glm::vec2(0.0f));
+
+        forRange(0, static_cast<uint32_t>(height), 8, [&](uint32_t first, uint32_t last) {
+            for (uint32_t row = first; row < last; row++) {
+                fieldRow(static_cast<int>(row), width, gravityConstant, params, &field[static_cast<size_t>(row) * width]);
+            }
+        });
+    }
+
+private:
+    struct Arrays {
+        std::vector<float> x, y, z, vx, vy, radius, mass;
+        std::vector<int32_t> species;
+        std::vector<glm::vec4> color;
+        std::vector<uint32_t> id; // Index in load()'s input
+
+        void resize(size_t n) {
+            x.resize(n);
+            y.resize(n);
+            z.resize(n);
+            vx.resize(n);
+            vy.resize(n);
+            radius.resize(n);
+            mass.resize(n);
+            species.resize(n);
+            color.resize(n);
+            id.resize(n);
+        }
+    };
+
+    // Contiguous particle index range
+    struct Range {
+        uint32_t begin, end;
+    };
+
+    SpeciesBlock table;
+    int speciesCount;
+    const ObstacleField* obstacles;
+    WorkStealingPool* pool;
+    cpu_kernels::KernelSet active;
+    bool deterministic = false;
+
+    Arrays state;
+    Arrays next;
+
+    // Uniform grid over the domain, rebuilt every substep
+    int cellsX = 1;
+    int cellsY = 1;
+    glm::vec2 cellSize = glm::vec2(1.0f);
+    std::vector<uint32_t> cellOf;     // Per particle, before sorting
+    std::vector<uint32_t> cellStart;  // cellsX * cellsY + 1 prefix sums
+    std::vector<uint32_t> order;      // Sorted position -> previous index
+
+    template <typename Body>
+    void forRange(uint32_t begin, uint32_t end, uint32_t grain, Body&& body) {
+        if (pool) pool->parallelFor(begin, end, grain, body);
+        else body(begin, end);
+    }
+
+    int32_t speciesOf(float id) const {
+        // Ids index the 4-wide pair rows, so they must stay in 0..3 for the kernels
+        return std::clamp(static_cast<int32_t>(id + 0.5f), 0, std::max(speciesCount, 1) - 1);
+    }
+
+    // Same as massOf() in physics.comp
+    void updateMasses() {
+        for (size_t i = 0; i < size(); i++) {
+            glm::vec4 params = table.params[state.species[i]];
+            float scale = params.y > 0.0f ? state.radius[i] / params.y : 1.0f;
+            state.mass[i] = params.x * scale * scale;
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 1. Binning
+    // ---------------------------------------------------------
+    glm::ivec2 cellCoord(float x, float y, const CpuPhysicsParams& params) const {
+        glm::vec2 local = (glm::vec2(x, y) + params.dimensions * 0.5f) / cellSize;
+        glm::ivec2 cell(static_cast<int>(std::floor(local.x)), static_cast<int>(std::floor(local.y)));
+        if (params.periodic) {
+            // Wrapped positions can still land exactly on the far edge
+            cell.x = ((cell.x % cellsX) + cellsX) % cellsX;
+            cell.y = ((cell.y % cellsY) + cellsY) % cellsY;
+            return cell;
+        }
+        return glm::ivec2(std::clamp(cell.x, 0, cellsX - 1), std::clamp(cell.y, 0, cellsY - 1));
+    }
+
+    void bin(const CpuPhysicsParams& params) {
+        uint32_t n = static_cast<uint32_t>(size());
+
+        // Cells at least as wide as the largest interaction: push reach, or
+        // the largest contact distance
+        float maxRadius = 0.0f;
+        for (float r : state.radius) maxRadius = std::max(maxRadius, r);
+        float reach = std::max(params.push ? params.smoothingRadius : 0.0f, 2.0f * maxRadius);
+        reach = std::max(reach, 1.0f);
+        cellsX = std::clamp(static_cast<int>(params.dimensions.x / reach), 1, 1024);
+        cellsY = std::clamp(static_cast<int>(params.dimensions.y / reach), 1, 1024);
+        cellSize = params.dimensions / glm::vec2(cellsX, cellsY);
+        uint32_t cellCount = static_cast<uint32_t>(cellsX * cellsY);
+
+        cellOf.resize(n);
+        forRange(0, n, 1024, [&](uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; i++) {
+                glm::ivec2 c = cellCoord(state.x[i], state.y[i], params);
+                cellOf[i] = static_cast<uint32_t>(c.y * cellsX + c.x);
+            }
+        });
+
+        // Stable counting sort: same input, same order, whatever the thread count
+        cellStart.assign(cellCount + 1, 0);
+        for (uint32_t i = 0; i < n; i++) cellStart[cellOf[i] + 1]++;
+        for (uint32_t c = 0; c < cellCount; c++) cellStart[c + 1] += cellStart[c];
+        order.resize(n);
+        std::vector<uint32_t> cursor(cellStart.begin(), cellStart.end() - 1);
+        for (uint32_t i = 0; i < n; i++) order[cursor[cellOf[i]]++] = i;
+
+        forRange(0, n, 1024, [&](uint32_t first, uint32_t last) {
+            for (uint32_t k = first; k < last; k++) {
+                uint32_t i = order[k];
+                next.x[k] = state.x[i];
+                next.y[k] = state.y[i];
+                next.z[k] = state.z[i];
+                next.vx[k] = state.vx[i];
+                next.vy[k] = state.vy[i];
+                next.radius[k] = state.radius[i];
+                next.mass[k] = state.mass[i];
+                next.species[k] = state.species[i];
+                next.color[k] = state.color[i];
+                next.id[k] = state.id[i];
+            }
+        });
+        std::swap(state, next);
+        // The per-particle constants must match in both buffers for the step
+        next.z = state.z;
+        next.radius = state.radius;
+        next.mass = state.mass;
+        next.species = state.species;
+        next.color = state.color;
+        next.id = state.id;
+    }
+
+    // Cell columns or rows within one cell of 'c' along an axis of 'cells',
+    // as at most two contiguous spans (a periodic wrap splits one)
+    static int neighbourSpans(int c, int cells, bool periodic, glm::ivec2 spans[2]) {
+        if (cells < 3) {
+            spans[0] = glm::ivec2(0, cells - 1); // Every cell is a neighbour
+            return 1;
+        }
+        if (!periodic) {
+            spans[0] = glm::ivec2(std::max(c - 1, 0), std::min(c + 1, cells - 1));
+            return 1;
+        }
+        if (c == 0) {
+            spans[0] = glm::ivec2(0, 1);
+            spans[1] = glm::ivec2(cells - 1, cells - 1);
+            return 2;
+        }
+        if (c == cells - 1) {
+            spans[0] = glm::ivec2(c - 1, c);
+            spans[1] = glm::ivec2(0, 0);
+            return 2;
+        }
+        spans[0] = glm::ivec2(c - 1, c + 1);
+        return 1;
+    }
+
+    // Particle ranges of the 3x3 block of cells around 'cell'; at most 4 * 2
+    // ranges. A range never includes 'self'.
+    int neighbourRanges(glm::ivec2 cell, uint32_t self, bool periodic, Range ranges[8]) const {
+        glm::ivec2 rows[2], cols[2];
+        int rowCount = neighbourSpans(cell.y, cellsY, periodic, rows);
+        int colCount = neighbourSpans(cell.x, cellsX, periodic, cols);
+
+        int count = 0;
+        auto add = [&](uint32_t begin, uint32_t end) {
+            if (begin < end) ranges[count++] = { begin, end };
+        };
+        for (int r = 0; r < rowCount; r++) {
+            for (int y = rows[r].x; y <= rows[r].y; y++) {
+                for (int c = 0; c < colCount; c++) {
+                    uint32_t begin = cellStart[y * cellsX + cols[c].x];
+                    uint32_t end = cellStart[y * cellsX + cols[c].y + 1];
+                    if (self >= begin && self < end) {
+                        add(begin, self);
+                        add(self + 1, end);
+                    } else {
+                        add(begin, end);
+                    }
+                }
+            }
+        }
+        return count;
+    }
+
+    // ---------------------------------------------------------
+    // 2. Per-cell step (physics.comp main())
+    // ---------------------------------------------------------
+    void stepParticles(uint32_t begin, uint32_t end, const cpu_kernels::Constants& constants,
+                       const CpuPhysicsParams& params) {
+        cpu_kernels::Neighbours neighbours = view();
+        float dt = constants.dt;
+        Range ranges[8];
+
+        for (uint32_t i = begin; i < end; i++) {
+            int species = state.species[i];
+            cpu_kernels::Body body{ state.x[i], state.y[i], state.vx[i], state.vy[i], state.radius[i], state.mass[i] };
+
+            // A. Global Downward Gravity
+            body.vy -= params.gravity * dt;
+
+            if (params.push) {
+                int count = neighbourRanges(cellCoord(body.x, body.y, params), i, params.periodic, ranges);
+                cpu_kernels::Delta push;
+                push.exact = deterministic;
+                for (int r = 0; r < count; r++) {
+                    active.push(neighbours, ranges[r].begin, ranges[r].end, body, &table.pairPush[species].x, constants, push);
+                }
+                push.resolve();
+                body.vx += push.vx;
+                body.vy += push.vy;
+            }
+
+            body.x += body.vx * dt;
+            body.y += body.vy * dt;
+
+            if (params.collisions) {
+                // Neighbours of where the particle is now, not where it was binned
+                int count = neighbourRanges(cellCoord(body.x, body.y, params), i, params.periodic, ranges);
+                cpu_kernels::Delta contact;
+                contact.exact = deterministic;
+                for (int r = 0; r < count; r++) {
+                    active.collide(neighbours, ranges[r].begin, ranges[r].end, body, &table.pairRestitution[species].x, constants, contact);
+                }
+                contact.resolve();
+                body.x += contact.px;
+                body.y += contact.py;
+                body.vx += contact.vx;
+                body.vy += contact.vy;
+            }
+
+            glm::vec2 pos(body.x, body.y);
+            glm::vec2 vel(body.vx, body.vy);
+            if (obstacles) resolveObstacles(pos, vel, body.radius, table.params[species].z);
+            resolveBoundaries(pos, vel, body.radius, params);
+
+            next.x[i] = pos.x;
+            next.y[i] = pos.y;
+            next.vx[i] = vel.x;
+            next.vy[i] = vel.y;
+        }
+    }
+
+    cpu_kernels::Neighbours view() const {
+        return { state.x.data(), state.y.data(), state.vx.data(), state.vy.data(),
+                 state.radius.data(), state.mass.data(), state.species.data() };
+    }
+
+    void resolveObstacles(glm::vec2& pos, glm::vec2& vel, float r, float restitution) const {
+        float d = obstacles->sample(pos) - r;
+        if (d >= 0.0f) return;
+
+        glm::vec2 grad(obstacles->sample(pos + glm::vec2(1.0f, 0.0f)) - obstacles->sample(pos - glm::vec2(1.0f, 0.0f)),
+                       obstacles->sample(pos + glm::vec2(0.0f, 1.0f)) - obstacles->sample(pos - glm::vec2(0.0f, 1.0f)));
+        float len = glm::length(grad);
+        if (len < 1e-6f) return;
+        glm::vec2 n = grad / len;
+
+        pos -= n * d;
+        float vn = glm::dot(vel, n);
+        if (vn < 0.0f) vel -= (1.0f + restitution) * vn * n;
+    }
+
+    static void resolveBoundaries(glm::vec2& pos, glm::vec2& vel, float r, const CpuPhysicsParams& params) {
+        glm::vec2 half = params.dimensions * 0.5f;
+        if (params.periodic) {
+            pos = glm::mod(pos + half, params.dimensions) - half;
+            return;
+        }
+        for (int axis = 0; axis < 2; axis++) {
+            if (pos[axis] - r < -half[axis]) {
+                pos[axis] = -half[axis] + r;
+                vel[axis] = std::abs(vel[axis]);
+            } else if (pos[axis] + r > half[axis]) {
+                pos[axis] = half[axis] - r;
+                vel[axis] = -std::abs(vel[axis]);
+            }
+        }
+    }
+
+    // ---------------------------------------------------------
+    // Field (gravity.comp), one grid row at a time
+    // ---------------------------------------------------------
+    void fieldRow(int row, int width, float gravityConstant, const CpuPhysicsParams& params, glm::vec2* out) const {
+        float cellY = row - params.dimensions.y * 0.5f + 0.5f;
+        glm::vec2 dims = params.dimensions;
+        auto minimumImage = [&](float d, float extent) {
+            return params.periodic ? d - extent * std::nearbyint(d / extent) : d;
+        };
+
+        // Kernel support is below one bin, so the bin rows around this row suffice
+        glm::ivec2 rows[2];
+        int rowCount = neighbourSpans(cellCoord(0.0f, cellY, params).y, cellsY, params.periodic, rows);
+        for (int r = 0; r < rowCount; r++) {
+            uint32_t begin = cellStart[rows[r].x * cellsX];
+            uint32_t end = cellStart[(rows[r].y + 1) * cellsX];
+            for (uint32_t i = begin; i < end; i++) {
+                float radius = state.radius[i];
+                float dy = minimumImage(state.y[i] - cellY, dims.y);
+                // Poly6 vanishes once dist^2 + SOFTENING >= r^2
+                float spanSq = radius * radius - SOFTENING - dy * dy;
+                if (spanSq <= 0.0f) continue;
+                float span = std::sqrt(spanSq);
+
+                float centre = state.x[i] + dims.x * 0.5f - 0.5f; // Grid x of the particle
+                int first = static_cast<int>(std::ceil(centre - span));
+                int last = static_cast<int>(std::floor(centre + span));
+                for (int gx = first; gx <= last; gx++) {
+                    int x = gx;
+                    if (params.periodic) x = ((gx % width) + width) % width;
+                    else if (gx < 0 || gx >= width) continue;
+
+                    float cellX = x - dims.x * 0.5f + 0.5f;
+                    glm::vec2 diff(minimumImage(state.x[i] - cellX, dims.x), dy);
+                    float distSq = glm::dot(diff, diff);
+                    if (distSq < 0.001f) continue;
+
+                    float value = std::max(0.0f, radius * radius - (distSq + SOFTENING));
+                    out[x] += glm::normalize(diff) * (value * value * value * gravityConstant);
+                }
+            }
+        }
+    }
+};
+
+#endif // CPU_PHYSICS_H
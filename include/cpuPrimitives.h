@@ -0,0 +1,55 @@
+#ifndef CPU_PRIMITIVES_H
+#define CPU_PRIMITIVES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// CPU reference versions of the GpuPrimitives operations, with identical results
+// (same stability and digit width), for checking GPU output and for CPU paths.
+namespace cpu {
+
+inline void exclusiveScan(std::vector<uint32_t>& data) {
+    uint32_t sum = 0;
+    for (uint32_t& value : data) {
+        uint32_t v = value;
+        value = sum;
+        sum += v;
+    }
+}
+
+// Stable LSD radix sort, 4 bits per pass, over the lowest 'keyBits' bits
+inline void radixSort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, int keyBits = 32) {
+    const int BITS_PER_PASS = 4;
+    const uint32_t RADIX = 1u << BITS_PER_PASS;
+
+    std::vector<uint32_t> keysOut(keys.size());
+    std::vector<uint32_t> valuesOut(values.size());
+    for (int shift = 0; shift < keyBits; shift += BITS_PER_PASS) {
+        std::vector<uint32_t> offsets(RADIX, 0);
+        for (uint32_t key : keys) offsets[(key >> shift) & (RADIX - 1)]++;
+        exclusiveScan(offsets);
+
+        for (size_t i = 0; i < keys.size(); i++) {
+            uint32_t dst = offsets[(keys[i] >> shift) & (RADIX - 1)]++;
+            keysOut[dst] = keys[i];
+            valuesOut[dst] = values[i];
+        }
+        keys.swap(keysOut);
+        values.swap(valuesOut);
+    }
+}
+
+// Indices of non-zero flags, in order
+inline std::vector<uint32_t> compact(const std::vector<uint32_t>& flags) {
+    std::vector<uint32_t> indices;
+    for (size_t i = 0; i < flags.size(); i++) {
+        if (flags[i] != 0) indices.push_back(static_cast<uint32_t>(i));
+    }
+    return indices;
+}
+
+} // namespace cpu
+
+#endif // CPU_PRIMITIVES_H
@@ -0,0 +1,132 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "barrierTracker.h"
+#include "computeShader.h"
+
+// std430 layout of 'Stats' in shaders/reduce.comp
+struct SimStats {
+    glm::vec4 energyMomentum; // x = kinetic energy, yz = momentum, w = max speed
+    glm::vec4 bounds;         // min x, min y, max x, max y
+    glm::vec4 totals;         // x = particle count, y = total mass
+};
+
+// Energy / momentum / bounds / max speed every N frames without a full readback.
+// Two reduction dispatches fold the particle buffer into one 48-byte result,
+// which is fetched once its fence signals (a frame or two later), never stalling.
+// Samples are printed and appended to a CSV so energy drift can be watched.
+class Diagnostics {
+public:
+    Diagnostics(GLuint capacity, BarrierTracker& barriers, const std::string& csvPath = "diagnostics.csv")
+        : barriers(barriers),
+          partialShader("shaders/reduce.comp", { {"WORKGROUP_SIZE", "256"}, {"FINAL", "0"} }),
+          finalShader("shaders/reduce.comp", { {"WORKGROUP_SIZE", "256"}, {"FINAL", "1"} }),
+          csv(csvPath) {
+        numPartials = (capacity + partialShader.workgroupSize() - 1) / partialShader.workgroupSize();
+
+        glGenBuffers(1, &partials);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, partials);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, numPartials * sizeof(SimStats), nullptr, GL_DYNAMIC_DRAW);
+        glGenBuffers(1, &result);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, result);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(SimStats), nullptr, GL_DYNAMIC_READ);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        csv << "frame,time,energy,px,py,maxSpeed,minX,minY,maxX,maxY,count,mass\n";
+    }
+
+    ~Diagnostics() {
+        if (fence) glDeleteSync(fence);
+        glDeleteBuffers(1, &partials);
+        glDeleteBuffers(1, &result);
+    }
+
+    Diagnostics(const Diagnostics&) = delete;
+    Diagnostics& operator=(const Diagnostics&) = delete;
+
+    // Queue a reduction of 'particles' unless the previous one is still in flight.
+    // Uses SSBO bindings 0-2 and 4. 'time' is simulated seconds, so deterministic runs log identical rows.
+    void sample(GLuint particles, GLuint counter, long long frame, double time) {
+        if (fence) return;
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particles);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, partials);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, result);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, counter);
+
+        partialShader.use();
+        barriers.pass("reduce partials", {{particles, Usage::ShaderStorage}, {counter, Usage::ShaderStorage}}, {partials});
+        partialShader.dispatch(numPartials, 1, 1);
+
+        finalShader.use();
+        finalShader.setInt("numPartials", (int)numPartials);
+        barriers.pass("reduce final", {{partials, Usage::ShaderStorage}}, {result});
+        finalShader.dispatch(1, 1, 1);
+
+        barriers.host("diagnostics readback", result);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        pendingFrame = frame;
+        pendingTime = time;
+    }
+
+    // Non-blocking: log the last sample if the GPU has finished it
+    bool poll() {
+        if (!fence) return false;
+        if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) return false;
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, result);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(SimStats), &latest);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        float energy = latest.energyMomentum.x;
+        if (!haveBaseline) {
+            baselineEnergy = energy;
+            haveBaseline = true;
+        }
+        float drift = baselineEnergy != 0.0f ? (energy - baselineEnergy) / baselineEnergy * 100.0f : 0.0f;
+
+        std::cout << "\n[diag] frame " << pendingFrame << std::fixed << std::setprecision(3)
+                  << " | E " << energy << " (" << std::showpos << drift << std::noshowpos << "%)"
+                  << " | p (" << latest.energyMomentum.y << ", " << latest.energyMomentum.z << ")"
+                  << " | max |v| " << latest.energyMomentum.w
+                  << " | bounds [" << latest.bounds.x << ", " << latest.bounds.y << "] - ["
+                  << latest.bounds.z << ", " << latest.bounds.w << "]\n";
+
+        csv << pendingFrame << "," << pendingTime << "," << energy << ","
+            << latest.energyMomentum.y << "," << latest.energyMomentum.z << "," << latest.energyMomentum.w << ","
+            << latest.bounds.x << "," << latest.bounds.y << "," << latest.bounds.z << "," << latest.bounds.w << ","
+            << latest.totals.x << "," << latest.totals.y << "\n";
+        return true;
+    }
+
+    const SimStats& last() const { return latest; }
+
+private:
+    BarrierTracker& barriers;
+    ComputeShader partialShader;
+    ComputeShader finalShader;
+    GLuint numPartials = 1;
+    GLuint partials = 0;
+    GLuint result = 0;
+
+    GLsync fence = nullptr;
+    long long pendingFrame = 0;
+    double pendingTime = 0.0;
+
+    SimStats latest{};
+    bool haveBaseline = false;
+    float baselineEnergy = 0.0f;
+    std::ofstream csv;
+};
+
+#endif // DIAGNOSTICS_H
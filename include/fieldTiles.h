@@ -0,0 +1,98 @@
+#ifndef FIELD_TILES_H
+#define FIELD_TILES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+
+#include "barrierTracker.h"
+#include "computeShader.h"
+
+// Tile occupancy for the field pass. The field grid is split into TILE_SIZE^2
+// tiles; tileOccupancy.comp flags the ones some particle's kernel reaches and
+// builds a compact list plus its indirect dispatch, so gravity.comp (built with
+// SPARSE_TILES) only runs where the field can be non-zero. Everything else is
+// left at zero by a buffer clear, which is far cheaper than evaluating it.
+class FieldTiles {
+public:
+    static constexpr int TILE_SIZE = 16;
+    static constexpr GLuint LIST_BINDING = 5;
+    static constexpr GLuint FLAGS_BINDING = 6;
+
+    // 'width' x 'height' is the field grid the tiles cover
+    FieldTiles(int width, int height, GLuint capacity, BarrierTracker& barriers)
+        : tilesX((width + TILE_SIZE - 1) / TILE_SIZE), tilesY((height + TILE_SIZE - 1) / TILE_SIZE),
+          capacity(capacity), barriers(barriers),
+          occupancyShader("shaders/tileOccupancy.comp", { {"TILE_SIZE", std::to_string(TILE_SIZE)} }) {
+        GLsizeiptr tileCount = static_cast<GLsizeiptr>(tilesX) * tilesY;
+
+        glGenBuffers(1, &list);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, list);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, HEADER_BYTES + tileCount * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+        glGenBuffers(1, &flags);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, flags);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, tileCount * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    ~FieldTiles() {
+        glDeleteBuffers(1, &list);
+        glDeleteBuffers(1, &flags);
+    }
+
+    FieldTiles(const FieldTiles&) = delete;
+    FieldTiles& operator=(const FieldTiles&) = delete;
+
+    // Rebuild the active tile list from 'particles'. Uses bindings 0, 4, 5 and 6.
+    void build(GLuint particles, GLuint counter, glm::vec2 dimensions) {
+        // Header back to an empty dispatch (0, 1, 1), flags to zero. Clears are
+        // buffer updates, so last frame's shader writes must land first.
+        barriers.host("tile reset", list);
+        barriers.host("tile reset", flags);
+        const GLuint emptyDispatch[4] = { 0, 1, 1, 0 };
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, list);
+        glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_RGBA32UI, 0, HEADER_BYTES, GL_RGBA_INTEGER, GL_UNSIGNED_INT, emptyDispatch);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, flags);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particles);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, counter);
+        bind();
+        occupancyShader.use();
+        occupancyShader.setVec2("dimensions", dimensions);
+        occupancyShader.setInt("tilesX", tilesX);
+        occupancyShader.setInt("tilesY", tilesY);
+        barriers.pass("tile occupancy", {{particles, Usage::ShaderStorage}, {counter, Usage::ShaderStorage}}, {list, flags});
+        // Dead slots exit on the live count, like morton.comp
+        occupancyShader.dispatch1D(capacity);
+    }
+
+    void bind() const {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIST_BINDING, list);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, FLAGS_BINDING, flags);
+    }
+
+    // One TILE_SIZE x TILE_SIZE workgroup per active tile
+    void dispatchIndirect() const {
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, list);
+        glDispatchComputeIndirect(0);
+    }
+
+    ComputeShader& shader() { return occupancyShader; }
+
+    GLuint list = 0;
+    const int tilesX;
+    const int tilesY;
+
+private:
+    static constexpr GLsizeiptr HEADER_BYTES = 4 * sizeof(GLuint);
+
+    GLuint capacity;
+    BarrierTracker& barriers;
+    ComputeShader occupancyShader;
+    GLuint flags = 0;
+};
+
+#endif // FIELD_TILES_H
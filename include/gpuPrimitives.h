@@ -0,0 +1,267 @@
+#ifndef GPU_PRIMITIVES_H
+#define GPU_PRIMITIVES_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "barrierTracker.h"
+#include "computeShader.h"
+#include "cpuPrimitives.h"
+
+// Shared parallel building blocks on uint SSBOs, for any pass that needs them
+// (neighbour grids, Morton reordering, depth sorting, compaction):
+//
+//   exclusiveScan  in-place exclusive prefix sum (multi-level, any length)
+//   radixSort      stable LSD sort of uint keys with uint payloads, 4 bits per pass
+//   compact        indices of non-zero flags packed to the front, plus their count
+//
+// Scratch buffers are sized for 'capacity' elements up front. Every dispatch is
+// declared to the BarrierTracker. SSBO bindings 0-4 are used freely, so callers
+// rebind their own afterwards. cpuPrimitives.h has reference versions.
+class GpuPrimitives {
+public:
+    static constexpr int BITS_PER_PASS = 4;
+    static constexpr int RADIX = 1 << BITS_PER_PASS;
+
+    GpuPrimitives(GLuint capacity, BarrierTracker& barriers)
+        : capacity(capacity), barriers(barriers),
+          histogramShader("shaders/radixHistogram.comp", { {"WORKGROUP_SIZE", "256"} }),
+          scatterShader("shaders/radixScatter.comp", { {"WORKGROUP_SIZE", "256"} }),
+          scanShader("shaders/scan.comp", { {"WORKGROUP_SIZE", "256"} }),
+          scanAddShader("shaders/scanAdd.comp", { {"WORKGROUP_SIZE", "256"} }),
+          compactShader("shaders/compact.comp", { {"WORKGROUP_SIZE", "256"} }) {
+        blockSize = histogramShader.workgroupSize();
+
+        tmpKeys = createBuffer(capacity);
+        tmpValues = createBuffer(capacity);
+        histogram = createBuffer(RADIX * blocksFor(capacity));
+
+        // One block-sum buffer per level of the recursive scan; the radix
+        // histogram is the longest thing ever scanned
+        GLuint longest = std::max(capacity, RADIX * blocksFor(capacity));
+        for (GLuint n = longest; n > 1; n = blocksFor(n)) {
+            scanLevels.push_back(createBuffer(blocksFor(n)));
+        }
+    }
+
+    ~GpuPrimitives() {
+        glDeleteBuffers(1, &tmpKeys);
+        glDeleteBuffers(1, &tmpValues);
+        glDeleteBuffers(1, &histogram);
+        glDeleteBuffers(static_cast<GLsizei>(scanLevels.size()), scanLevels.data());
+    }
+
+    GpuPrimitives(const GpuPrimitives&) = delete;
+    GpuPrimitives& operator=(const GpuPrimitives&) = delete;
+
+    // Helper for callers' own uint buffers
+    static GLuint createBuffer(GLuint uints) {
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<GLuint>(uints, 1) * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return buffer;
+    }
+
+    // In-place exclusive prefix sum of 'count' uints
+    void exclusiveScan(GLuint data, GLuint count) {
+        checkCount(count, std::max(capacity, RADIX * blocksFor(capacity)));
+        if (count == 0) return;
+        scanLevel(data, count, 0);
+    }
+
+    // Stable sort of the first 'count' keys (lowest 'keyBits' bits) with their values
+    void radixSort(GLuint keys, GLuint values, GLuint count, int keyBits = 32) {
+        checkCount(count, capacity);
+        if (count <= 1) return;
+
+        int passes = (keyBits + BITS_PER_PASS - 1) / BITS_PER_PASS;
+        passes += passes & 1; // even, so the result ends up back in 'keys'/'values'
+
+        GLuint numBlocks = blocksFor(count);
+        GLuint keysIn = keys, valuesIn = values;
+        GLuint keysOut = tmpKeys, valuesOut = tmpValues;
+
+        for (int pass = 0; pass < passes; pass++) {
+            int shift = pass * BITS_PER_PASS;
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, keysIn);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, histogram);
+            histogramShader.use();
+            histogramShader.setInt("count", (int)count);
+            histogramShader.setInt("shift", shift);
+            histogramShader.setInt("numBlocks", (int)numBlocks);
+            barriers.pass("radix histogram", {{keysIn, Usage::ShaderStorage}}, {histogram});
+            histogramShader.dispatch(numBlocks, 1, 1);
+
+            scanLevel(histogram, RADIX * numBlocks, 0);
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, keysIn);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, valuesIn);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, histogram);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, keysOut);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, valuesOut);
+            scatterShader.use();
+            scatterShader.setInt("count", (int)count);
+            scatterShader.setInt("shift", shift);
+            scatterShader.setInt("numBlocks", (int)numBlocks);
+            barriers.pass("radix scatter", {{keysIn, Usage::ShaderStorage}, {valuesIn, Usage::ShaderStorage},
+                                            {histogram, Usage::ShaderStorage}}, {keysOut, valuesOut});
+            scatterShader.dispatch(numBlocks, 1, 1);
+
+            std::swap(keysIn, keysOut);
+            std::swap(valuesIn, valuesOut);
+        }
+    }
+
+    // Writes the index of every non-zero entry of 'flags' (in order) to the front
+    // of 'indices', and the number written to total[totalIndex]. 'flags' is left
+    // untouched. 'total' can be an indirect-args buffer, so the result can size a
+    // later dispatch without a readback.
+    void compact(GLuint flags, GLuint count, GLuint indices, GLuint total, GLuint totalIndex = 0) {
+        checkCount(count, capacity);
+        if (count == 0) return;
+
+        // Scan a copy; tmpKeys is free outside radixSort
+        barriers.host("compact copy", flags);
+        barriers.host("compact copy", tmpKeys);
+        glBindBuffer(GL_COPY_READ_BUFFER, flags);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, tmpKeys);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, count * sizeof(GLuint));
+        scanLevel(tmpKeys, count, 0);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, flags);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, tmpKeys);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indices);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, total);
+        compactShader.use();
+        compactShader.setInt("count", (int)count);
+        compactShader.setInt("totalIndex", (int)totalIndex);
+        barriers.pass("compact", {{flags, Usage::ShaderStorage}, {tmpKeys, Usage::ShaderStorage}}, {indices, total});
+        compactShader.dispatch(blocksFor(count), 1, 1);
+    }
+
+    // Runs every primitive on random data and compares with the CPU reference
+    bool selfTest() {
+        GLuint n = std::min<GLuint>(capacity, 5000);
+        std::mt19937 rng(1234);
+        std::vector<uint32_t> keys(n), values(n), flags(n);
+        for (GLuint i = 0; i < n; i++) {
+            keys[i] = rng();
+            values[i] = i;
+            flags[i] = rng() % 3 == 0;
+        }
+
+        GLuint keyBuffer = createBuffer(n), valueBuffer = createBuffer(n);
+        GLuint indexBuffer = createBuffer(n), totalBuffer = createBuffer(1);
+        upload(keyBuffer, keys);
+        upload(valueBuffer, values);
+
+        bool ok = true;
+
+        radixSort(keyBuffer, valueBuffer, n);
+        std::vector<uint32_t> expectKeys = keys, expectValues = values;
+        cpu::radixSort(expectKeys, expectValues);
+        ok &= report("radixSort keys", download(keyBuffer, n) == expectKeys);
+        ok &= report("radixSort values", download(valueBuffer, n) == expectValues);
+
+        std::vector<uint32_t> small(n);
+        for (uint32_t& v : small) v = rng() % 100;
+        upload(keyBuffer, small);
+        exclusiveScan(keyBuffer, n);
+        cpu::exclusiveScan(small);
+        ok &= report("exclusiveScan", download(keyBuffer, n) == small);
+
+        upload(keyBuffer, flags);
+        compact(keyBuffer, n, indexBuffer, totalBuffer);
+        std::vector<uint32_t> expectIndices = cpu::compact(flags);
+        std::vector<uint32_t> total = download(totalBuffer, 1);
+        std::vector<uint32_t> indices = download(indexBuffer, static_cast<GLuint>(expectIndices.size()));
+        ok &= report("compact", total[0] == expectIndices.size() && indices == expectIndices);
+
+        for (GLuint buffer : { keyBuffer, valueBuffer, indexBuffer, totalBuffer }) {
+            barriers.forget(buffer);
+            glDeleteBuffers(1, &buffer);
+        }
+        return ok;
+    }
+
+private:
+    GLuint capacity;
+    BarrierTracker& barriers;
+    ComputeShader histogramShader;
+    ComputeShader scatterShader;
+    ComputeShader scanShader;
+    ComputeShader scanAddShader;
+    ComputeShader compactShader;
+    GLuint blockSize = 256;
+
+    GLuint tmpKeys = 0;
+    GLuint tmpValues = 0;
+    GLuint histogram = 0;
+    std::vector<GLuint> scanLevels;
+
+    GLuint blocksFor(GLuint n) const { return (n + blockSize - 1) / blockSize; }
+
+    void upload(GLuint buffer, const std::vector<uint32_t>& data) {
+        barriers.host("selftest upload", buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, data.size() * sizeof(uint32_t), data.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    std::vector<uint32_t> download(GLuint buffer, GLuint count) {
+        std::vector<uint32_t> data(count);
+        barriers.host("selftest download", buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(uint32_t), data.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return data;
+    }
+
+    static bool report(const char* name, bool ok) {
+        std::cout << "  " << name << (ok ? ": ok\n" : ": MISMATCH\n");
+        return ok;
+    }
+
+    static void checkCount(GLuint count, GLuint limit) {
+        if (count > limit) {
+            throw std::runtime_error("GpuPrimitives: " + std::to_string(count) +
+                                     " elements exceeds capacity " + std::to_string(limit));
+        }
+    }
+
+    void scanLevel(GLuint data, GLuint count, size_t level) {
+        GLuint groups = blocksFor(count);
+        GLuint sums = scanLevels[level];
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, data);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sums);
+        scanShader.use();
+        scanShader.setInt("count", (int)count);
+        barriers.pass("scan", {{data, Usage::ShaderStorage}}, {data, sums});
+        scanShader.dispatch(groups, 1, 1);
+
+        if (groups > 1) {
+            scanLevel(sums, groups, level + 1);
+
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, data);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sums);
+            scanAddShader.use();
+            scanAddShader.setInt("count", (int)count);
+            barriers.pass("scan add", {{data, Usage::ShaderStorage}, {sums, Usage::ShaderStorage}}, {data});
+            scanAddShader.dispatch(groups, 1, 1);
+        }
+    }
+};
+
+#endif // GPU_PRIMITIVES_H
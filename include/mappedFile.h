@@ -0,0 +1,180 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A whole file mapped into memory.
+//
+// Read maps an existing file read-only. Write creates (truncating) a file that
+// grows through reserve(); the OS writes dirty pages back in the background, so
+// appending is a memcpy. Growing remaps the file, which invalidates pointers
+// into data(). close() trims a written file to the bytes actually used.
+class MappedFile {
+public:
+    enum class Mode { Read, Write };
+
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, Mode mode) {
+        close();
+        this->mode = mode;
+#ifdef _WIN32
+        DWORD access = mode == Mode::Read ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+        DWORD disposition = mode == Mode::Read ? OPEN_EXISTING : CREATE_ALWAYS;
+        file = CreateFileA(path.c_str(), access, FILE_SHARE_READ, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return fail(path, "could not open");
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        fileSize = static_cast<size_t>(size.QuadPart);
+#else
+        fd = mode == Mode::Read ? ::open(path.c_str(), O_RDONLY) : ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return fail(path, "could not open");
+        struct stat st;
+        fstat(fd, &st);
+        fileSize = static_cast<size_t>(st.st_size);
+#endif
+        this->path = path;
+        if (fileSize > 0 && !map(fileSize)) {
+            close();
+            return fail(path, "could not map");
+        }
+        return true;
+    }
+
+    // Write mode: make at least 'bytes' addressable, growing geometrically
+    bool reserve(size_t bytes) {
+        if (bytes <= fileSize) return true;
+        if (mode != Mode::Write || !isOpen()) return false;
+        size_t grown = fileSize < 1024 * 1024 ? 1024 * 1024 : fileSize;
+        while (grown < bytes) grown *= 2;
+
+        unmap();
+#ifndef _WIN32
+        if (ftruncate(fd, static_cast<off_t>(grown)) != 0) return fail(path, "could not grow");
+#endif
+        if (!map(grown)) return fail(path, "could not map");
+        return true;
+    }
+
+    // Schedule written pages for write-back without waiting for the disk
+    void flush() {
+        if (!view || mode != Mode::Write) return;
+#ifdef _WIN32
+        FlushViewOfFile(view, 0);
+#else
+        msync(view, fileSize, MS_ASYNC);
+#endif
+    }
+
+    // 'usedBytes' (write mode) trims the reserved tail off the file
+    void close(size_t usedBytes = SIZE_MAX) {
+        if (!isOpen()) return;
+        unmap();
+        bool trim = mode == Mode::Write && usedBytes < fileSize;
+#ifdef _WIN32
+        if (trim) {
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(usedBytes);
+            SetFilePointerEx(file, end, nullptr, FILE_BEGIN);
+            SetEndOfFile(file);
+        }
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (trim && ftruncate(fd, static_cast<off_t>(usedBytes)) != 0) {
+            std::cerr << "MappedFile: could not trim " << path << "\n";
+        }
+        ::close(fd);
+        fd = -1;
+#endif
+        fileSize = 0;
+    }
+
+    bool isOpen() const {
+#ifdef _WIN32
+        return file != INVALID_HANDLE_VALUE;
+#else
+        return fd >= 0;
+#endif
+    }
+
+    unsigned char* data() { return static_cast<unsigned char*>(view); }
+    const unsigned char* data() const { return static_cast<const unsigned char*>(view); }
+    size_t size() const { return fileSize; } // Mapped bytes (including reserve in write mode)
+
+private:
+    Mode mode = Mode::Read;
+    std::string path;
+    void* view = nullptr;
+    size_t fileSize = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    bool map(size_t bytes) {
+#ifdef _WIN32
+        DWORD protect = mode == Mode::Read ? PAGE_READONLY : PAGE_READWRITE;
+        // A write mapping larger than the file extends it
+        mapping = CreateFileMappingA(file, nullptr, protect, static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32),
+                                     static_cast<DWORD>(bytes), nullptr);
+        if (!mapping) return false;
+        view = MapViewOfFile(mapping, mode == Mode::Read ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0, bytes);
+        if (!view) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            return false;
+        }
+#else
+        int protect = mode == Mode::Read ? PROT_READ : PROT_READ | PROT_WRITE;
+        void* p = mmap(nullptr, bytes, protect, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return false;
+        view = p;
+#endif
+        fileSize = bytes;
+        return true;
+    }
+
+    void unmap() {
+        if (!view) return;
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(view, fileSize);
+#endif
+        view = nullptr;
+    }
+
+    static bool fail(const std::string& path, const char* what) {
+        std::cerr << "MappedFile: " << what << " " << path << "\n";
+        return false;
+    }
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,46 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "particle.h"
+
+// Z-order (Morton) keys over the simulation domain, centred on the origin.
+// Must stay in sync with mortonKey() in shaders/morton.comp.
+
+// Spread the low 16 bits of v so there is a zero between each pair
+inline uint32_t mortonSpread(uint32_t v) {
+    v &= 0x0000FFFFu;
+    v = (v | (v << 8)) & 0x00FF00FFu;
+    v = (v | (v << 4)) & 0x0F0F0F0Fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+inline uint32_t mortonKey(glm::vec2 pos, glm::vec2 dimensions) {
+    glm::vec2 t = glm::clamp(pos / dimensions + 0.5f, 0.0f, 1.0f);
+    uint32_t qx = static_cast<uint32_t>(t.x * 65535.0f);
+    uint32_t qy = static_cast<uint32_t>(t.y * 65535.0f);
+    return mortonSpread(qx) | (mortonSpread(qy) << 1);
+}
+
+// CPU equivalent of the GPU Morton reorder: stable, so equal keys keep their order
+inline void mortonSortCPU(std::vector<Particle>& particles, glm::vec2 dimensions) {
+    std::vector<std::pair<uint32_t, uint32_t>> keyed(particles.size());
+    for (size_t i = 0; i < particles.size(); i++) {
+        keyed[i] = { mortonKey(glm::vec2(particles[i].pos_radius), dimensions), static_cast<uint32_t>(i) };
+    }
+    std::stable_sort(keyed.begin(), keyed.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<Particle> sorted(particles.size());
+    for (size_t i = 0; i < keyed.size(); i++) sorted[i] = particles[keyed[i].second];
+    particles.swap(sorted);
+}
+
+#endif // MORTON_H
@@ -0,0 +1,71 @@
+#ifndef MORTON_SORTER_H
+#define MORTON_SORTER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "barrierTracker.h"
+#include "computeShader.h"
+#include "particle.h"
+#include "gpuPrimitives.h"
+
+// Reorders particle state along a Z-order curve on the GPU so particles that are
+// close in space are close in memory (see mortonSortCPU in morton.h for the CPU
+// equivalent). Sorts the whole buffer: dead slots get the largest key and stay
+// behind the live range, so the CPU never needs the live count.
+class MortonSorter {
+public:
+    MortonSorter(GLuint capacity, BarrierTracker& barriers, GpuPrimitives& primitives)
+        : capacity(capacity), barriers(barriers), primitives(primitives),
+          keyShader("shaders/morton.comp"),
+          reorderShader("shaders/reorder.comp") {
+        keys = GpuPrimitives::createBuffer(capacity);
+        order = GpuPrimitives::createBuffer(capacity);
+    }
+
+    ~MortonSorter() {
+        glDeleteBuffers(1, &keys);
+        glDeleteBuffers(1, &order);
+    }
+
+    MortonSorter(const MortonSorter&) = delete;
+    MortonSorter& operator=(const MortonSorter&) = delete;
+
+    // Writes 'src' sorted by Morton code of pos_radius.xy into 'dst'.
+    // 'counter' is the SimState buffer holding the live count.
+    void sort(GLuint src, GLuint dst, GLuint counter, glm::vec2 dimensions) {
+        // 1. Keys + identity order
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, keys);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, order);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, counter);
+        keyShader.use();
+        keyShader.setVec2("dimensions", dimensions);
+        keyShader.setInt("capacity", (int)capacity);
+        barriers.pass("morton keys", {{src, Usage::ShaderStorage}, {counter, Usage::ShaderStorage}}, {keys, order});
+        keyShader.dispatch1D(capacity);
+
+        // 2. Sort the order by key
+        primitives.radixSort(keys, order, capacity);
+
+        // 3. Gather
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, src);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, dst);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, order);
+        reorderShader.use();
+        reorderShader.setInt("capacity", (int)capacity);
+        barriers.pass("morton reorder", {{src, Usage::ShaderStorage}, {order, Usage::ShaderStorage}}, {dst});
+        reorderShader.dispatch1D(capacity);
+    }
+
+private:
+    GLuint capacity;
+    BarrierTracker& barriers;
+    GpuPrimitives& primitives;
+    ComputeShader keyShader;
+    ComputeShader reorderShader;
+    GLuint keys = 0;
+    GLuint order = 0;
+};
+
+#endif // MORTON_SORTER_H
@@ -0,0 +1,212 @@
+#ifndef OBSTACLES_H
+#define OBSTACLES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "stb_image.h"
+
+// Analytic obstacle primitive, in world units (origin at the screen centre)
+struct ObstacleShape {
+    enum class Type { Circle, Box };
+
+    Type type;
+    glm::vec2 center;
+    glm::vec2 size; // Circle: x = radius. Box: half extents.
+
+    static ObstacleShape circle(glm::vec2 center, float radius) {
+        return { Type::Circle, center, glm::vec2(radius, 0.0f) };
+    }
+
+    static ObstacleShape box(glm::vec2 center, glm::vec2 halfExtents) {
+        return { Type::Box, center, halfExtents };
+    }
+
+    // Signed distance, negative inside
+    float distance(glm::vec2 p) const {
+        glm::vec2 local = p - center;
+        if (type == Type::Circle) return glm::length(local) - size.x;
+        glm::vec2 q = glm::abs(local) - size;
+        return glm::length(glm::max(q, glm::vec2(0.0f))) + std::min(std::max(q.x, q.y), 0.0f);
+    }
+};
+
+// Static obstacles baked into a signed distance field texture (GL_R32F, one
+// texel per world unit, negative inside). Physics samples it once per particle
+// and takes the normal from its gradient, so the cost is the same for one
+// circle or an arbitrarily detailed image mask.
+class ObstacleField {
+public:
+    static constexpr GLuint TEXTURE_UNIT = 0; // layout(binding = 0) in the shaders
+
+    std::vector<ObstacleShape> shapes;
+
+    // Image mask stretched over the whole domain; bright pixels are solid.
+    // Returns false (and leaves the field unchanged) if the file can't be read.
+    bool loadMask(const std::string& path) {
+        int w, h, channels;
+        unsigned char* pixels = stbi_load(path.c_str(), &w, &h, &channels, 1);
+        if (!pixels) {
+            std::cerr << "ObstacleField: could not load " << path << ": " << stbi_failure_reason() << "\n";
+            return false;
+        }
+        maskWidth = w;
+        maskHeight = h;
+        mask.assign(pixels, pixels + static_cast<size_t>(w) * h);
+        stbi_image_free(pixels);
+        return true;
+    }
+
+    bool empty() const { return shapes.empty() && mask.empty(); }
+
+    // Bakes shapes and mask for a width x height domain into distances(),
+    // without touching GL (the headless run needs no context); upload() sends
+    // them to the texture
+    void bakeDistances(int width, int height) {
+        worldSize = glm::vec2(width, height);
+        sdfWidth = width;
+        sdfHeight = height;
+        std::vector<float>& sdf = distances;
+        sdf.assign(static_cast<size_t>(width) * height, std::numeric_limits<float>::max());
+
+        if (!mask.empty()) sdf = maskDistance(width, height);
+
+        // Texel (x, y) covers the same world point as field cell (x, y)
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                glm::vec2 p(x + 0.5f - width * 0.5f, y + 0.5f - height * 0.5f);
+                float& d = sdf[static_cast<size_t>(y) * width + x];
+                for (const ObstacleShape& shape : shapes) d = std::min(d, shape.distance(p));
+            }
+        }
+    }
+
+    // Uploads the baked distances as the SDF texture
+    void upload() {
+        if (!texture) glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, sdfWidth, sdfHeight, 0, GL_RED, GL_FLOAT, distances.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Bilinear, clamp-to-edge lookup matching textureLod() in physics.comp
+    float sample(glm::vec2 p) const {
+        float fx = std::clamp(p.x + worldSize.x * 0.5f - 0.5f, 0.0f, static_cast<float>(sdfWidth - 1));
+        float fy = std::clamp(p.y + worldSize.y * 0.5f - 0.5f, 0.0f, static_cast<float>(sdfHeight - 1));
+        int x0 = static_cast<int>(fx);
+        int y0 = static_cast<int>(fy);
+        int x1 = std::min(x0 + 1, sdfWidth - 1);
+        int y1 = std::min(y0 + 1, sdfHeight - 1);
+        float tx = fx - x0;
+        float ty = fy - y0;
+        auto at = [&](int x, int y) { return distances[static_cast<size_t>(y) * sdfWidth + x]; };
+        float bottom = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * tx;
+        float top = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * tx;
+        return bottom + (top - bottom) * ty;
+    }
+
+    void bind() const {
+        glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+
+    void destroy() {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+
+    GLuint texture = 0;
+    glm::vec2 worldSize = glm::vec2(0.0f); // Domain the texture spans
+
+private:
+    std::vector<float> distances; // Row-major, bottom row first
+    int sdfWidth = 0;
+    int sdfHeight = 0;
+    std::vector<unsigned char> mask;
+    int maskWidth = 0;
+    int maskHeight = 0;
+
+    // Exact Euclidean distance transform of the mask resampled to the domain:
+    // distance to the nearest solid texel outside, minus distance to the
+    // nearest free texel inside.
+    std::vector<float> maskDistance(int width, int height) const {
+        std::vector<unsigned char> solid(static_cast<size_t>(width) * height);
+        for (int y = 0; y < height; y++) {
+            // Image rows run top to bottom, world y runs up
+            int my = (height - 1 - y) * maskHeight / height;
+            for (int x = 0; x < width; x++) {
+                int mx = x * maskWidth / width;
+                solid[static_cast<size_t>(y) * width + x] = mask[static_cast<size_t>(my) * maskWidth + mx] > 127;
+            }
+        }
+
+        std::vector<float> outside = squaredDistance(solid, width, height, true);
+        std::vector<float> inside = squaredDistance(solid, width, height, false);
+        std::vector<float> sdf(solid.size());
+        for (size_t i = 0; i < sdf.size(); i++) {
+            // Half a texel puts the zero crossing on the boundary between texels
+            sdf[i] = solid[i] ? 0.5f - std::sqrt(inside[i]) : std::sqrt(outside[i]) - 0.5f;
+        }
+        return sdf;
+    }
+
+    // Squared distance to the nearest texel whose solid flag equals 'target'
+    // (Felzenszwalb & Huttenlocher: two separable 1D lower-envelope passes)
+    static std::vector<float> squaredDistance(const std::vector<unsigned char>& solid, int width, int height, bool target) {
+        const float INF = 1e20f;
+        std::vector<float> grid(solid.size());
+        for (size_t i = 0; i < solid.size(); i++) grid[i] = (solid[i] != 0) == target ? 0.0f : INF;
+
+        int n = std::max(width, height);
+        std::vector<float> f(n), d(n), z(n + 1);
+        std::vector<int> v(n);
+        auto transform1D = [&](int length) {
+            int k = 0;
+            v[0] = 0;
+            z[0] = -INF;
+            z[1] = INF;
+            for (int q = 1; q < length; q++) {
+                float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+                while (s <= z[k]) {
+                    k--;
+                    s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+                }
+                k++;
+                v[k] = q;
+                z[k] = s;
+                z[k + 1] = INF;
+            }
+            k = 0;
+            for (int q = 0; q < length; q++) {
+                while (z[k + 1] < q) k++;
+                float dq = static_cast<float>(q - v[k]);
+                d[q] = dq * dq + f[v[k]];
+            }
+        };
+
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) f[y] = grid[static_cast<size_t>(y) * width + x];
+            transform1D(height);
+            for (int y = 0; y < height; y++) grid[static_cast<size_t>(y) * width + x] = d[y];
+        }
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) f[x] = grid[static_cast<size_t>(y) * width + x];
+            transform1D(width);
+            for (int x = 0; x < width; x++) grid[static_cast<size_t>(y) * width + x] = d[x];
+        }
+        return grid;
+    }
+};
+
+#endif // OBSTACLES_H
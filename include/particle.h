@@ -0,0 +1,13 @@
+#ifndef PARTICLE_H
+#define PARTICLE_H
+
+#include <glm/glm.hpp>
+
+// Matches the std430 'Particle' struct declared in every shader
+struct alignas(16) Particle {
+    glm::vec4 pos_radius; // x,y,z, radius
+    glm::vec4 velocity; 
+    glm::vec4 color;
+};
+
+#endif // PARTICLE_H
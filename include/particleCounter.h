@@ -0,0 +1,63 @@
+#ifndef PARTICLE_COUNTER_H
+#define PARTICLE_COUNTER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// std430 layout of the SimState block (binding 4) shared by the compute shaders
+struct SimState {
+    uint32_t particleCount;
+    uint32_t pad[3];
+    uint32_t physicsDispatch[4]; // DispatchIndirectCommand (+1 unused)
+    uint32_t drawCommand[4];     // DrawArraysIndirectCommand
+};
+
+// GPU-resident live particle count plus the indirect arguments derived from it
+// (written by indirectArgs.comp). Dispatch and draw sizes come straight from this
+// buffer, so nothing on the CPU needs to know the count per frame.
+class ParticleCounter {
+public:
+    static constexpr GLuint BINDING = 4;
+
+    GLuint buffer = 0;
+
+    void init(uint32_t initialCount) {
+        SimState state{};
+        state.particleCount = initialCount;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(SimState), &state, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void destroy() {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+
+    // Host overwrite of the count (initial upload, benchmarks). Discards any
+    // change the GPU made since.
+    void setCount(uint32_t count) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, offsetof(SimState, particleCount), sizeof(uint32_t), &count);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void bind() const {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, buffer);
+    }
+
+    void dispatchIndirect() const {
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buffer);
+        glDispatchComputeIndirect(offsetof(SimState, physicsDispatch));
+    }
+
+    void drawIndirect(GLenum mode) const {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+        glDrawArraysIndirect(mode, reinterpret_cast<const void*>(offsetof(SimState, drawCommand)));
+    }
+};
+
+#endif // PARTICLE_COUNTER_H
@@ -0,0 +1,249 @@
+#ifndef PARTICLE_IMPORTER_H
+#define PARTICLE_IMPORTER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "cpuPrimitives.h"
+#include "mappedFile.h"
+#include "particle.h"
+#include "snapshotCodec.h"
+#include "workStealingPool.h"
+
+// Initial conditions from a file, in one of:
+//   - CSV with the columns writeCsv() (and so dumpParticlesToFile()) writes
+//     (index,x,y,z,r,vx,vy,vz,vw,cr,cg,cb,ca; the header line is optional
+//     and the index column is ignored)
+//   - a compressed snapshot (recognized by its header, whatever the name)
+//   - a raw array of Particle, as in GPU memory (any other file whose size is
+//     a multiple of sizeof(Particle))
+//
+// Files are memory-mapped and parsed in parallel: CSV is split into ranges at
+// line boundaries, one pass counts the records in each range, a scan turns the
+// counts into output offsets and a second pass parses every range straight
+// into its place. The number parser works on the mapped bytes in place, so
+// nothing is allocated per line or per field.
+namespace importer {
+
+constexpr int CSV_COLUMNS = 13;
+
+// The CSV format parseCsv() reads: a header line, then one record per particle
+// with its index and every component at 4 decimals
+inline void writeCsv(std::ostream& out, const Particle* particles, size_t count) {
+    out << std::fixed << std::setprecision(4);
+    out << "index,x,y,z,r,vx,vy,vz,vw,cr,cg,cb,ca\n";
+    for (size_t i = 0; i < count; ++i) {
+        const Particle& p = particles[i];
+        out << i << ","
+            << p.pos_radius.x << "," << p.pos_radius.y << "," << p.pos_radius.z << "," << p.pos_radius.w << ","
+            << p.velocity.x   << "," << p.velocity.y   << "," << p.velocity.z   << "," << p.velocity.w   << ","
+            << p.color.r      << "," << p.color.g      << "," << p.color.b      << "," << p.color.a
+            << "\n";
+    }
+}
+
+// [sign] digits [. digits] [e|E [sign] digits], "inf" or "nan". Returns the end
+// of the number, or nullptr if there is none at 'p'. Up to 19 significant
+// digits are used, then one scaling by an exact power of ten, which is exact
+// for the "%.4f" values the dump writes and within an ulp otherwise.
+inline const char* parseFloat(const char* p, const char* end, float& value) {
+    static const double POWERS[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    if (end - p >= 3 && (std::memcmp(p, "inf", 3) == 0 || std::memcmp(p, "nan", 3) == 0)) {
+        value = *p == 'i' ? std::numeric_limits<float>::infinity() : std::numeric_limits<float>::quiet_NaN();
+        if (negative) value = -value;
+        return p + 3;
+    }
+
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    bool any = false;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, any = true) {
+        if (significant < 19) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            if (mantissa != 0) significant++;
+        } else {
+            exponent++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, any = true) {
+            if (significant < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                if (mantissa != 0) significant++;
+                exponent--;
+            }
+        }
+    }
+    if (!any) return nullptr;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q < end && (*q == '-' || *q == '+')) negativeExponent = *q++ == '-';
+        if (q < end && *q >= '0' && *q <= '9') {
+            int e = 0;
+            for (; q < end && *q >= '0' && *q <= '9'; q++) e = std::min(e * 10 + (*q - '0'), 100000);
+            exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+
+    double v = static_cast<double>(mantissa);
+    if (mantissa == 0) v = 0.0;
+    else if (exponent >= 0 && exponent <= 22) v *= POWERS[exponent];
+    else if (exponent < 0 && exponent >= -22) v /= POWERS[-exponent];
+    else v *= std::pow(10.0, exponent);
+    value = static_cast<float>(negative ? -v : v);
+    return p;
+}
+
+namespace detail {
+
+inline bool blank(const char* line, const char* end) {
+    for (; line < end; line++) {
+        if (*line != ' ' && *line != '\t' && *line != '\r') return false;
+    }
+    return true;
+}
+
+inline const char* lineEnd(const char* p, const char* end) {
+    const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return newline ? static_cast<const char*>(newline) : end;
+}
+
+// One CSV record into 'out'; false if a field is missing or malformed
+inline bool parseRecord(const char* p, const char* end, Particle& out) {
+    float v[CSV_COLUMNS];
+    for (int column = 0; column < CSV_COLUMNS; column++) {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        p = parseFloat(p, end, v[column]);
+        if (!p) return false;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+        if (column + 1 < CSV_COLUMNS) {
+            if (p == end || *p != ',') return false;
+            p++;
+        }
+    }
+    if (p != end) return false;
+    out.pos_radius = glm::vec4(v[1], v[2], v[3], v[4]);
+    out.velocity = glm::vec4(v[5], v[6], v[7], v[8]);
+    out.color = glm::vec4(v[9], v[10], v[11], v[12]);
+    return true;
+}
+
+} // namespace detail
+
+// 'error' gets a message naming the first bad line, if any
+inline bool parseCsv(const char* data, size_t size, std::vector<Particle>& out, WorkStealingPool& pool, std::string& error) {
+    const char* begin = data;
+    const char* end = data + size;
+    // A header is a first line that does not start like a number
+    if (begin < end && !((*begin >= '0' && *begin <= '9') || *begin == '-' || *begin == '+' || *begin == '.')) {
+        begin = detail::lineEnd(begin, end);
+        if (begin < end) begin++;
+    }
+    uint32_t headerLines = begin == data ? 0 : 1;
+
+    // Ranges of about 1 MB, each starting at a line
+    const size_t RANGE_BYTES = 1 << 20;
+    std::vector<const char*> starts;
+    for (const char* p = begin; p < end;) {
+        starts.push_back(p);
+        const char* next = p + std::min(RANGE_BYTES, static_cast<size_t>(end - p));
+        if (next < end) {
+            next = detail::lineEnd(next, end);
+            if (next < end) next++;
+        }
+        p = next;
+    }
+    uint32_t ranges = static_cast<uint32_t>(starts.size());
+    starts.push_back(end);
+
+    // Pass 1: records and lines per range
+    std::vector<uint32_t> records(ranges), lines(ranges);
+    pool.parallelFor(0, ranges, 1, [&](uint32_t first, uint32_t last) {
+        for (uint32_t r = first; r < last; r++) {
+            uint32_t count = 0, lineCount = 0;
+            for (const char* p = starts[r]; p < starts[r + 1]; lineCount++) {
+                const char* e = detail::lineEnd(p, starts[r + 1]);
+                if (!detail::blank(p, e)) count++;
+                p = e < starts[r + 1] ? e + 1 : e;
+            }
+            records[r] = count;
+            lines[r] = lineCount;
+        }
+    });
+    std::vector<uint32_t> offsets = records;
+    std::vector<uint32_t> firstLine = lines;
+    cpu::exclusiveScan(offsets);
+    cpu::exclusiveScan(firstLine);
+    out.resize(ranges > 0 ? static_cast<size_t>(offsets.back()) + records.back() : 0);
+
+    // Pass 2: parse each range into its slice of 'out'
+    std::atomic<uint32_t> firstBadLine{ UINT32_MAX };
+    pool.parallelFor(0, ranges, 1, [&](uint32_t first, uint32_t last) {
+        for (uint32_t r = first; r < last; r++) {
+            Particle* dst = out.data() + offsets[r];
+            uint32_t line = firstLine[r] + headerLines + 1;
+            for (const char* p = starts[r]; p < starts[r + 1]; line++) {
+                const char* e = detail::lineEnd(p, starts[r + 1]);
+                if (!detail::blank(p, e) && !detail::parseRecord(p, e, *dst++)) {
+                    uint32_t seen = firstBadLine.load();
+                    while (line < seen && !firstBadLine.compare_exchange_weak(seen, line)) {}
+                    break;
+                }
+                p = e < starts[r + 1] ? e + 1 : e;
+            }
+        }
+    });
+    if (firstBadLine.load() != UINT32_MAX) {
+        error = "line " + std::to_string(firstBadLine.load()) + " is not " + std::to_string(CSV_COLUMNS) + " numbers";
+        return false;
+    }
+    return true;
+}
+
+inline bool load(const std::string& path, std::vector<Particle>& out, WorkStealingPool& pool) {
+    MappedFile file;
+    if (!file.open(path, MappedFile::Mode::Read)) return false;
+    const uint8_t* data = file.data();
+    size_t size = file.size();
+
+    auto fail = [&](const std::string& reason) {
+        std::cerr << "Importer: " << path << ": " << reason << "\n";
+        return false;
+    };
+    std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (snapshot::isSnapshot(data, size)) {
+        if (!snapshot::decode(data, size, out, pool)) return fail("damaged snapshot, or from a build with another Particle layout");
+    } else if (extension == ".csv") {
+        std::string error;
+        if (!parseCsv(reinterpret_cast<const char*>(data), size, out, pool, error)) return fail(error);
+    } else if (size % sizeof(Particle) == 0) {
+        out.resize(size / sizeof(Particle));
+        if (size > 0) std::memcpy(out.data(), data, size);
+    } else {
+        return fail("not a .csv, a snapshot or a whole number of particles");
+    }
+    return true;
+}
+
+} // namespace importer
+
+#endif // PARTICLE_IMPORTER_H
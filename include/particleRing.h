@@ -0,0 +1,113 @@
+#ifndef PARTICLE_RING_H
+#define PARTICLE_RING_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// Ring of particle state buffers with fence-tracked ownership.
+//
+// One slot is "presented" (drawn this frame), the simulation writes into the
+// others, and a slot can be "pinned" for a CPU readback. A pinned slot is never
+// written until its fence signals and the readback is consumed, so the CPU can
+// read an older state without stalling the simulation or the render.
+class ParticleRing {
+public:
+    static constexpr int SLOTS = 3;
+
+    GLuint buffers[SLOTS] = {};
+
+    void init(GLsizeiptr bytes, const void* data) {
+        size = bytes;
+        glGenBuffers(SLOTS, buffers);
+        for (int i = 0; i < SLOTS; i++) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[i]);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, data, GL_DYNAMIC_DRAW);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void destroy() {
+        if (readbackFence) glDeleteSync(readbackFence);
+        readbackFence = nullptr;
+        glDeleteBuffers(SLOTS, buffers);
+    }
+
+    // Zero a whole slot on the GPU
+    void clear(int slot) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[slot]);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // Host data into part of a slot, e.g. an initial scene piece by piece
+    void upload(int slot, GLintptr offset, GLsizeiptr bytes, const void* data) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[slot]);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, bytes, data);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    GLuint buffer(int slot) const { return buffers[slot]; }
+    int presented() const { return presentedSlot; }
+    GLuint presentedBuffer() const { return buffers[presentedSlot]; }
+    bool readbackPending() const { return pinnedSlot >= 0; }
+
+    // Pick the slot a pass reading 'source' should write to.
+    // Prefers a slot that is neither presented nor pinned so the write can overlap
+    // the draw. Falls back to the presented slot (GL orders it after the draw) and
+    // never hands out the pinned slot.
+    int acquire(int source) const {
+        for (int k = 1; k < SLOTS; k++) {
+            int s = (source + k) % SLOTS;
+            if (s != presentedSlot && s != pinnedSlot) return s;
+        }
+        for (int k = 1; k < SLOTS; k++) {
+            int s = (source + k) % SLOTS;
+            if (s != pinnedSlot) return s;
+        }
+        return -1; // unreachable while at most one slot is pinned
+    }
+
+    // The slot holding the newest state becomes the one drawn next frame
+    void present(int slot) { presentedSlot = slot; }
+
+    // Pin the presented slot for readback. Call after the commands that produced it
+    // have been queued and GL_BUFFER_UPDATE_BARRIER_BIT has been issued for it;
+    // the fence marks the point the CPU may read it.
+    bool pinPresented() {
+        if (pinnedSlot >= 0) return false;
+        pinnedSlot = presentedSlot;
+        readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        return true;
+    }
+
+    // Non-blocking: if the pinned slot's fence has signaled, map it, hand the data to
+    // 'consume(const void* data, GLsizeiptr bytes)' and release the pin.
+    template <typename F>
+    bool pollReadback(F&& consume) {
+        if (pinnedSlot < 0) return false;
+        GLenum status = glClientWaitSync(readbackFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED) return false;
+
+        glDeleteSync(readbackFence);
+        readbackFence = nullptr;
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[pinnedSlot]);
+        const void* data = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, GL_MAP_READ_BIT);
+        if (data) {
+            consume(data, size);
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        pinnedSlot = -1;
+        return data != nullptr;
+    }
+
+private:
+    GLsizeiptr size = 0;
+    int presentedSlot = 0;
+    int pinnedSlot = -1;
+    GLsync readbackFence = nullptr;
+};
+
+#endif // PARTICLE_RING_H
@@ -0,0 +1,119 @@
+#ifndef PARTICLE_STORE_H
+#define PARTICLE_STORE_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "particle.h"
+#include "particleCounter.h"
+#include "particleRing.h"
+
+// The simulation's particles. They live only on the GPU, in the ring (state)
+// and the counter (live count + indirect args); the host keeps the count and
+// nothing else, and reaches the data through explicit sync points:
+//   upload()           host particles into the presented slot
+//   append()           queue one particle; emitPending() hands the queue to
+//                      the emit pass, which appends it on the GPU
+//   requestDownload()  pin the presented slot; pollDownload() delivers it
+//                      once its fence signals, without stalling
+//   download()         blocking copy of the presented slot (checkpoints)
+// Like the ring, the store issues no barriers: callers declare their accesses
+// to BarrierTracker before uploads and downloads.
+class ParticleStore {
+public:
+    static constexpr uint32_t UPLOAD_CHUNK = 65536; // Particles per glBufferSubData, to keep the driver's staging copy small
+
+    ParticleRing ring;
+    ParticleCounter counter;
+
+    // Empty store of 'capacity' particles per slot
+    void init(uint32_t capacity) {
+        maxCount = capacity;
+        ring.init(static_cast<GLsizeiptr>(capacity) * sizeof(Particle), nullptr);
+        for (int slot = 0; slot < ParticleRing::SLOTS; slot++) ring.clear(slot);
+        counter.init(0);
+        liveCount = 0;
+        pending.clear();
+    }
+
+    void destroy() {
+        ring.destroy();
+        counter.destroy();
+        pending.clear();
+    }
+
+    uint32_t count() const { return liveCount; }
+    uint32_t capacity() const { return maxCount; }
+
+    // Host overwrite of the count, e.g. after a GPU pass wrote the particles
+    void setCount(uint32_t count) {
+        liveCount = std::min(count, maxCount);
+        counter.setCount(liveCount);
+    }
+
+    // Particles [first, first + n) of the presented slot; the live range grows
+    // to cover them. Only the presented slot is written: every physics step
+    // copies the live particles forward into the slot it writes.
+    void upload(uint32_t first, const Particle* data, uint32_t n) {
+        if (first >= maxCount) return;
+        n = std::min(n, maxCount - first);
+        for (uint32_t done = 0; done < n; done += UPLOAD_CHUNK) {
+            uint32_t chunk = std::min(UPLOAD_CHUNK, n - done);
+            ring.upload(ring.presented(), static_cast<GLintptr>(first + done) * sizeof(Particle),
+                        static_cast<GLsizeiptr>(chunk) * sizeof(Particle), data + done);
+        }
+        if (first + n > liveCount) setCount(first + n);
+    }
+
+    // Counted at once so capacity checks see it; false when the store is full
+    bool append(const Particle& particle) {
+        if (liveCount >= maxCount) return false;
+        pending.push_back(particle);
+        liveCount++;
+        return true;
+    }
+
+    // 'emit(const Particle&)' once per particle appended since the last call
+    template <typename F>
+    void emitPending(F&& emit) {
+        for (const Particle& particle : pending) emit(particle);
+        pending.clear();
+    }
+
+    // Pins the presented slot for pollDownload(); false while one is in flight
+    bool requestDownload() {
+        if (!ring.pinPresented()) return false;
+        downloadCount = liveCount - static_cast<uint32_t>(pending.size());
+        return true;
+    }
+
+    // Non-blocking: 'consume(const Particle* data, uint32_t count)' once the
+    // requested slot is readable
+    template <typename F>
+    bool pollDownload(F&& consume) {
+        return ring.pollReadback([&](const void* data, GLsizeiptr) {
+            consume(static_cast<const Particle*>(data), downloadCount);
+        });
+    }
+
+    bool downloadPending() const { return ring.readbackPending(); }
+
+    // Blocking copy of the live particles in the presented slot
+    void download(std::vector<Particle>& out) const {
+        out.resize(liveCount - pending.size());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ring.presentedBuffer());
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(out.size() * sizeof(Particle)), out.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+private:
+    uint32_t maxCount = 0;
+    uint32_t liveCount = 0;     // Mirror of the GPU count, including queued appends
+    uint32_t downloadCount = 0; // Live particles in the pinned slot
+    std::vector<Particle> pending;
+};
+
+#endif // PARTICLE_STORE_H
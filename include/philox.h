@@ -0,0 +1,76 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstdint>
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+//
+// A counter-based generator: the output is a pure function of (counter, key),
+// so a stream is reproducible from its seed alone, any position can be jumped
+// to directly, and streams with different ids never overlap.
+using PhiloxCounter = std::array<uint32_t, 4>;
+using PhiloxKey = std::array<uint32_t, 2>;
+
+inline PhiloxCounter philox4x32_10(PhiloxCounter ctr, PhiloxKey key) {
+    const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = static_cast<uint64_t>(M0) * ctr[0];
+        uint64_t p1 = static_cast<uint64_t>(M1) * ctr[2];
+        ctr = { static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(p1),
+                static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(p0) };
+        key[0] += W0;
+        key[1] += W1;
+    }
+    return ctr;
+}
+
+// Sequential draws from one (seed, stream) pair. The low half of the counter
+// counts blocks of four outputs; the high half holds the stream id.
+class PhiloxStream {
+public:
+    explicit PhiloxStream(uint64_t seed = 0, uint64_t stream = 0)
+        : key{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) }, stream(stream) {}
+
+    uint32_t nextUint() {
+        if (used == 4) refill();
+        return block[used++];
+    }
+
+    // [0, 1) with 24 random bits, exact in a float
+    float nextFloat() { return static_cast<float>(nextUint() >> 8) * (1.0f / 16777216.0f); }
+
+    float uniform(float lo, float hi) { return lo + (hi - lo) * nextFloat(); }
+
+    uint64_t seed() const { return key[0] | (static_cast<uint64_t>(key[1]) << 32); }
+    uint64_t streamId() const { return stream; }
+
+    // Number of values drawn so far; seek() restores it, e.g. from a checkpoint
+    uint64_t position() const { return blockIndex * 4 - (4 - used); }
+
+    void seek(uint64_t position) {
+        blockIndex = position / 4;
+        used = 4;
+        if (position % 4 != 0) {
+            refill();
+            used = static_cast<int>(position % 4);
+        }
+    }
+
+private:
+    PhiloxKey key;
+    uint64_t stream;
+    uint64_t blockIndex = 0; // Next block to generate
+    PhiloxCounter block{};
+    int used = 4;
+
+    void refill() {
+        block = philox4x32_10({ static_cast<uint32_t>(blockIndex), static_cast<uint32_t>(blockIndex >> 32),
+                                static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32) }, key);
+        blockIndex++;
+        used = 0;
+    }
+};
+
+#endif // PHILOX_H
@@ -0,0 +1,151 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// One stage of a program: GL shader type, full source, and a label for error logs
+struct ShaderStage {
+    GLenum type;
+    std::string source;
+    std::string label;
+};
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Entries are keyed by a hash of every stage's source plus the driver string, so
+// editing a shader or updating the driver simply misses and recompiles.
+class ProgramCache {
+public:
+    inline static bool enabled = true;
+    inline static std::string directory = "shader_cache";
+
+    static uint64_t key(const std::vector<ShaderStage>& stages) {
+        uint64_t h = 14695981039346656037ull; // FNV-1a 64
+        auto mix = [&h](const void* data, size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; i++) {
+                h ^= bytes[i];
+                h *= 1099511628211ull;
+            }
+        };
+        std::string driver = driverString();
+        mix(driver.data(), driver.size());
+        for (const ShaderStage& stage : stages) {
+            mix(&stage.type, sizeof(stage.type));
+            mix(stage.source.data(), stage.source.size());
+        }
+        return h;
+    }
+
+    // Returns a linked program, or 0 if there is no usable entry
+    static GLuint load(uint64_t key) {
+        if (!available()) return 0;
+
+        std::ifstream in(pathFor(key), std::ios::binary);
+        if (!in) return 0;
+
+        Header header{};
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!in || header.magic != MAGIC || header.version != VERSION || header.key != key ||
+            header.driverLength > 4096 || header.binaryLength > (64u << 20)) {
+            return 0;
+        }
+        std::string driver(header.driverLength, '\0');
+        in.read(driver.data(), header.driverLength);
+        std::vector<char> binary(header.binaryLength);
+        in.read(binary.data(), header.binaryLength);
+        if (!in || driver != driverString()) return 0;
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            // The driver rejected it (e.g. internal format changed); drop the entry
+            glDeleteProgram(program);
+            in.close();
+            std::error_code ec;
+            std::filesystem::remove(pathFor(key), ec);
+            return 0;
+        }
+        return program;
+    }
+
+    // The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+    static void store(uint64_t key, GLuint program) {
+        if (!available()) return;
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) return;
+
+        std::string driver = driverString();
+        Header header{ MAGIC, VERSION, format, static_cast<uint32_t>(length),
+                       static_cast<uint32_t>(driver.size()), key };
+
+        // Write to a temporary name and rename, so concurrent batch runs never read a torn file
+        std::string path = pathFor(key);
+        std::string tmp = path + ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            if (!out) return;
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(driver.data(), driver.size());
+            out.write(binary.data(), binary.size());
+        }
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) std::filesystem::remove(tmp, ec);
+    }
+
+    static bool available() {
+        if (!enabled) return false;
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+private:
+    static constexpr uint32_t MAGIC = 0x4E494250; // "PBIN"
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        GLenum   format;
+        uint32_t binaryLength;
+        uint32_t driverLength;
+        uint64_t key;
+    };
+
+    static std::string driverString() {
+        auto str = [](GLenum name) {
+            const GLubyte* s = glGetString(name);
+            return s ? std::string(reinterpret_cast<const char*>(s)) : std::string();
+        };
+        return str(GL_VENDOR) + "|" + str(GL_RENDERER) + "|" + str(GL_VERSION);
+    }
+
+    static std::string pathFor(uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return (std::filesystem::path(directory) / name).string();
+    }
+};
+
+#endif // PROGRAM_CACHE_H
@@ -0,0 +1,149 @@
+#ifndef RANS_H
+#define RANS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Order-0 byte-wise rANS (Duda, "Asymmetric numeral systems"; the layout
+// follows Giesen's ryg_rans). Compresses close to the entropy of the byte
+// histogram at a few ns per byte, which is all the snapshot codec needs from
+// its entropy stage.
+//
+// Encoded block: symbolCount (u16) | (symbol u8, frequency u16) * symbolCount |
+//                rANS bytes (both states first, big-endian)
+// The decoder must be told how many bytes to produce.
+namespace rans {
+
+constexpr uint32_t SCALE_BITS = 12;
+constexpr uint32_t SCALE = 1u << SCALE_BITS;
+constexpr uint32_t LOWER = 1u << 23; // State stays in [LOWER, LOWER << 8)
+
+// Histogram scaled to sum to SCALE, keeping every present symbol at >= 1
+inline void normalize(const uint32_t counts[256], uint32_t total, uint32_t freq[256]) {
+    uint32_t sum = 0;
+    for (int s = 0; s < 256; s++) {
+        freq[s] = counts[s] == 0 ? 0 : std::max<uint32_t>(1, static_cast<uint32_t>(uint64_t(counts[s]) * SCALE / total));
+        sum += freq[s];
+    }
+    // Rounding leaves sum within 256 of SCALE; settle the difference on the largest symbols
+    while (sum != SCALE) {
+        int largest = static_cast<int>(std::max_element(freq, freq + 256) - freq);
+        if (sum > SCALE) {
+            freq[largest]--;
+            sum--;
+        } else {
+            freq[largest] += SCALE - sum;
+            sum = SCALE;
+        }
+    }
+}
+
+inline void encode(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    uint32_t counts[256] = {};
+    for (size_t i = 0; i < size; i++) counts[data[i]]++;
+    uint32_t freq[256], cum[257] = {};
+    if (size > 0) normalize(counts, static_cast<uint32_t>(size), freq);
+    else std::fill(freq, freq + 256, 0u);
+    for (int s = 0; s < 256; s++) cum[s + 1] = cum[s] + freq[s];
+
+    uint16_t symbols = static_cast<uint16_t>(std::count_if(freq, freq + 256, [](uint32_t f) { return f != 0; }));
+    out.push_back(static_cast<uint8_t>(symbols));
+    out.push_back(static_cast<uint8_t>(symbols >> 8));
+    for (int s = 0; s < 256; s++) {
+        if (freq[s] == 0) continue;
+        out.push_back(static_cast<uint8_t>(s));
+        out.push_back(static_cast<uint8_t>(freq[s]));
+        out.push_back(static_cast<uint8_t>(freq[s] >> 8));
+    }
+
+    // Division-free encoding: x / f becomes a multiply by a fixed-point reciprocal
+    struct Symbol {
+        uint32_t limit, reciprocal, bias;
+        uint16_t complement, shift;
+    } table[256];
+    for (int s = 0; s < 256; s++) {
+        Symbol& e = table[s];
+        uint32_t f = std::max<uint32_t>(freq[s], 1);
+        e.limit = ((LOWER >> SCALE_BITS) << 8) * f;
+        e.complement = static_cast<uint16_t>(SCALE - f);
+        if (f < 2) {
+            e.reciprocal = ~0u;
+            e.shift = 0;
+            e.bias = cum[s] + SCALE - 1;
+        } else {
+            uint32_t shift = 0;
+            while (f > (1u << shift)) shift++;
+            e.reciprocal = static_cast<uint32_t>(((1ull << (shift + 31)) + f - 1) / f);
+            e.shift = static_cast<uint16_t>(shift - 1);
+            e.bias = cum[s];
+        }
+    }
+
+    // Two interleaved states (even and odd symbols) let consecutive steps
+    // overlap. Symbols go in back to front so the decoder reads them front to
+    // back; the bytes come out reversed and are flipped at the end.
+    size_t start = out.size();
+    uint32_t state[2] = { LOWER, LOWER };
+    for (size_t i = size; i-- > 0;) {
+        const Symbol& e = table[data[i]];
+        uint32_t& x = state[i & 1];
+        while (x >= e.limit) {
+            out.push_back(static_cast<uint8_t>(x));
+            x >>= 8;
+        }
+        uint32_t q = static_cast<uint32_t>((static_cast<uint64_t>(x) * e.reciprocal) >> 32) >> e.shift;
+        x += e.bias + q * e.complement;
+    }
+    for (int k = 1; k >= 0; k--) {
+        for (int b = 0; b < 4; b++) {
+            out.push_back(static_cast<uint8_t>(state[k]));
+            state[k] >>= 8;
+        }
+    }
+    std::reverse(out.begin() + static_cast<std::ptrdiff_t>(start), out.end());
+}
+
+// Decodes 'size' bytes from [in, end); false if the block is malformed
+inline bool decode(const uint8_t* in, const uint8_t* end, uint8_t* out, size_t size) {
+    if (end - in < 2) return false;
+    uint32_t symbols = in[0] | (uint32_t(in[1]) << 8);
+    in += 2;
+    if (symbols > 256 || static_cast<size_t>(end - in) < symbols * 3 + 8) return false;
+
+    uint32_t freq[256] = {}, cum[256] = {};
+    uint8_t lookup[SCALE];
+    uint32_t total = 0;
+    for (uint32_t k = 0; k < symbols; k++, in += 3) {
+        uint8_t s = in[0];
+        freq[s] = in[1] | (uint32_t(in[2]) << 8);
+        if (freq[s] == 0 || total + freq[s] > SCALE) return false;
+        cum[s] = total;
+        std::memset(lookup + total, s, freq[s]);
+        total += freq[s];
+    }
+    if (size > 0 && total != SCALE) return false;
+
+    uint32_t state[2];
+    for (uint32_t& x : state) {
+        x = (uint32_t(in[0]) << 24) | (uint32_t(in[1]) << 16) | (uint32_t(in[2]) << 8) | in[3];
+        in += 4;
+    }
+    for (size_t i = 0; i < size; i++) {
+        uint32_t& x = state[i & 1];
+        uint32_t slot = x & (SCALE - 1);
+        uint8_t s = lookup[slot];
+        out[i] = s;
+        x = freq[s] * (x >> SCALE_BITS) + slot - cum[s];
+        while (x < LOWER) {
+            if (in == end) return false;
+            x = (x << 8) | *in++;
+        }
+    }
+    return true;
+}
+
+} // namespace rans
+
+#endif // RANS_H
@@ -0,0 +1,227 @@
+#ifndef REPLAY_PLAYER_H
+#define REPLAY_PLAYER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "particle.h"
+#include "trajectory.h"
+#include "uploadRing.h"
+
+// Plays a trajectory file back into SSBO slots without stalling the render.
+//
+// A worker thread decodes frames from the mapped file straight into upload
+// ring slots, ahead of the playhead in the direction of play. Each slot goes
+// Free -> Filling (worker) -> Ready -> Shown -> InFlight (fenced) -> Free, and
+// the render thread only ever flips a Ready slot to Shown or recycles slots
+// whose fence has signalled; it never waits for the worker or the GPU. If the
+// frame due is not decoded yet, the last shown frame is drawn again.
+class ReplayPlayer {
+public:
+    static constexpr int SLOTS = 6;     // Shown + in flight + prefetched
+    static constexpr int LOOKAHEAD = 3; // Frames requested beyond the one due
+
+    ~ReplayPlayer() { close(); }
+
+    bool open(const std::string& path) {
+        if (!reader.open(path)) return false;
+        if (reader.frames() == 0) {
+            std::cerr << "ReplayPlayer: " << path << " has no frames\n";
+            reader.close();
+            return false;
+        }
+        capacity = std::max(reader.maxCount(), 1u);
+        ring.init(static_cast<GLsizeiptr>(capacity) * sizeof(Particle), SLOTS);
+        slots.assign(SLOTS, Slot{});
+        startTime = reader.entry(0).time;
+        endTime = reader.entry(reader.frames() - 1).time;
+        playhead = startTime;
+        stopping = false;
+        worker = std::thread([this] { decodeLoop(); });
+        return true;
+    }
+
+    void close() {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            worker.join();
+        }
+        ring.destroy();
+        reader.close();
+        slots.clear();
+        shown = -1;
+    }
+
+    // Once per rendered frame: advance the playhead by 'seconds' of wall time,
+    // show the newest decoded frame and queue the next ones for the worker
+    void update(double seconds) {
+        if (!paused) {
+            playhead += seconds * playbackSpeed;
+            bool ended = playbackSpeed >= 0.0 ? playhead >= endTime : playhead <= startTime;
+            playhead = std::clamp(playhead, startTime, endTime);
+            if (ended) paused = true; // Stop at the end rather than wrapping
+        }
+        uint64_t target = reader.frameAt(playhead);
+        double step = (paused ? 0.0 : seconds * playbackSpeed);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        wanted.clear();
+        wanted.push_back(target);
+        if (step != 0.0) {
+            for (int k = 1; k <= LOOKAHEAD; k++) {
+                uint64_t frame = reader.frameAt(std::clamp(playhead + k * step, startTime, endTime));
+                if (std::find(wanted.begin(), wanted.end(), frame) == wanted.end()) wanted.push_back(frame);
+            }
+        } else {
+            // Paused: keep both neighbours ready for single steps
+            if (target > 0) wanted.push_back(target - 1);
+            if (target + 1 < reader.frames()) wanted.push_back(target + 1);
+        }
+
+        // Show the decoded frame nearest the target without running past it, so
+        // playback that outpaces the worker skips frames instead of freezing
+        bool forward = playbackSpeed >= 0.0;
+        auto distance = [&](uint64_t frame) {
+            return frame > target ? frame - target : target - frame;
+        };
+        int best = -1;
+        uint64_t bestDistance = shown >= 0 ? distance(slots[shown].frame) : UINT64_MAX;
+        for (int i = 0; i < SLOTS; i++) {
+            Slot& slot = slots[i];
+            if (slot.state == State::InFlight && ring.idle(i)) slot.state = State::Free;
+            if (slot.state != State::Ready) continue;
+            bool past = forward ? slot.frame > target : slot.frame < target;
+            if ((!past || slot.frame == target) && distance(slot.frame) < bestDistance) {
+                best = i;
+                bestDistance = distance(slot.frame);
+            }
+        }
+        if (best >= 0) {
+            if (shown >= 0) slots[shown].state = State::InFlight;
+            ring.publish(best, static_cast<GLsizeiptr>(slots[best].count) * sizeof(Particle));
+            slots[best].state = State::Shown;
+            shown = best;
+        }
+        // Nothing has read a Ready slot yet, so one that is no longer wanted is free
+        for (Slot& slot : slots) {
+            if (slot.state == State::Ready && std::find(wanted.begin(), wanted.end(), slot.frame) == wanted.end()) {
+                slot.state = State::Free;
+            }
+        }
+        wake.notify_one();
+    }
+
+    // Bind the shown frame to SSBO 'index'; returns its particle count (0 before the first frame)
+    uint32_t bind(GLuint index) {
+        if (shown < 0) return 0;
+        ring.bind(shown, index, static_cast<GLsizeiptr>(slots[shown].count) * sizeof(Particle));
+        return slots[shown].count;
+    }
+
+    // After the draws that read the shown frame
+    void drawn() {
+        if (shown >= 0) ring.fence(shown);
+    }
+
+    void seek(double time) { playhead = std::clamp(time, startTime, endTime); }
+
+    // Move by whole recorded frames (for stepping while paused)
+    void step(int frames) {
+        int64_t frame = static_cast<int64_t>(reader.frameAt(playhead)) + frames;
+        frame = std::clamp<int64_t>(frame, 0, static_cast<int64_t>(reader.frames()) - 1);
+        playhead = reader.entry(static_cast<uint64_t>(frame)).time;
+    }
+
+    void setSpeed(double speed) { playbackSpeed = speed; }
+    double speed() const { return playbackSpeed; }
+    void setPaused(bool value) { paused = value; }
+    bool isPaused() const { return paused; }
+
+    double time() const { return playhead; }
+    double duration() const { return endTime - startTime; }
+    double start() const { return startTime; }
+    double end() const { return endTime; }
+    uint64_t frames() const { return reader.frames(); }
+    // Frame on screen, which may trail the playhead while the worker catches up
+    int64_t shownFrame() const { return shown >= 0 ? static_cast<int64_t>(slots[shown].frame) : -1; }
+    bool persistentUpload() const { return ring.persistent(); }
+
+private:
+    enum class State { Free, Filling, Ready, Shown, InFlight };
+
+    struct Slot {
+        State state = State::Free;
+        uint64_t frame = 0;
+        uint32_t count = 0;
+    };
+
+    trajectory::Reader reader;
+    UploadRing ring;
+    uint32_t capacity = 0;
+    std::vector<Slot> slots;
+    int shown = -1;
+
+    double playhead = 0.0; // Recorded simulation time
+    double startTime = 0.0;
+    double endTime = 0.0;
+    double playbackSpeed = 1.0; // Simulated seconds per wall second; negative plays backwards
+    bool paused = false;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<uint64_t> wanted; // Most urgent first
+    bool stopping = false;
+
+    // Next wanted frame that is neither decoded nor being decoded, and a free slot for it
+    bool nextJob(uint64_t& frame, int& slot) const {
+        for (uint64_t candidate : wanted) {
+            bool present = std::any_of(slots.begin(), slots.end(), [&](const Slot& s) {
+                return s.state != State::Free && s.state != State::InFlight && s.frame == candidate;
+            });
+            if (present) continue;
+            for (int i = 0; i < SLOTS; i++) {
+                if (slots[i].state == State::Free) {
+                    frame = candidate;
+                    slot = i;
+                    return true;
+                }
+            }
+            return false;
+        }
+        return false;
+    }
+
+    void decodeLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            uint64_t frame = 0;
+            int slot = -1;
+            wake.wait(lock, [&] { return stopping || nextJob(frame, slot); });
+            if (stopping) return;
+
+            slots[slot].state = State::Filling;
+            slots[slot].frame = frame;
+            lock.unlock();
+            // The slot is idle on the GPU, so its memory is ours until it is Ready
+            uint32_t count = reader.read(frame, static_cast<Particle*>(ring.memory(slot)), capacity);
+            lock.lock();
+            slots[slot].count = count;
+            slots[slot].state = State::Ready;
+        }
+    }
+};
+
+#endif // REPLAY_PLAYER_H
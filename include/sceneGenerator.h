@@ -0,0 +1,131 @@
+#ifndef SCENE_GENERATOR_H
+#define SCENE_GENERATOR_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "barrierTracker.h"
+#include "computeShader.h"
+#include "gpuPrimitives.h"
+#include "particleCounter.h"
+
+enum class Scene { Grid = 0, Disc = 1, Random = 2, PoissonDisc = 3, DamBreak = 4 };
+
+struct SceneSpec {
+    Scene scene = Scene::Grid;
+    uint32_t count = 0;      // Ignored by PoissonDisc, which fills the domain
+    float spacing = 0.0f;    // Pitch, or the minimum distance for PoissonDisc
+    glm::vec2 dimensions{ 0.0f };
+    float radius = 1.0f;
+    int species = 0;
+    glm::vec4 color{ 1.0f };
+    uint64_t seed = 0;       // Random and PoissonDisc
+
+    static bool parse(const std::string& name, Scene& scene) {
+        if (name == "grid") scene = Scene::Grid;
+        else if (name == "disc") scene = Scene::Disc;
+        else if (name == "random") scene = Scene::Random;
+        else if (name == "poisson") scene = Scene::PoissonDisc;
+        else if (name == "dambreak") scene = Scene::DamBreak;
+        else return false;
+        return true;
+    }
+
+    // Candidate grid of PoissonDisc: one candidate per cell of spacing / sqrt(2)
+    glm::ivec2 cells() const {
+        glm::vec2 extent = glm::max(dimensions - 2.0f * radius, glm::vec2(0.0f));
+        glm::vec2 n = glm::ceil(extent / (spacing * 0.70710678f));
+        return glm::max(glm::ivec2(n), glm::ivec2(1));
+    }
+
+    // Particles the scene can produce, to size the buffers before generating
+    uint32_t maxCount() const {
+        if (scene != Scene::PoissonDisc) return count;
+        glm::ivec2 n = cells();
+        return static_cast<uint32_t>(n.x) * static_cast<uint32_t>(n.y);
+    }
+};
+
+// Builds an initial scene directly in a particle buffer with init.comp, so
+// setup costs one dispatch at any particle count and no particle data crosses
+// the bus. Poisson-disc sampling keeps a subset of jittered candidates; the
+// survivors are packed with GpuPrimitives::compact, in cell order, so the
+// result only depends on the seed.
+class SceneGenerator {
+public:
+    SceneGenerator(BarrierTracker& barriers, GpuPrimitives& primitives)
+        : barriers(barriers), primitives(primitives) {}
+
+    // Writes the scene to the front of 'target' and its size to the counter.
+    // 'scratch' (same capacity) holds Poisson-disc candidates. Returns the
+    // particle count; for Poisson-disc that is one 4-byte readback, at setup.
+    uint32_t generate(const SceneSpec& spec, GLuint target, GLuint scratch, ParticleCounter& counter) {
+        uint32_t items = spec.maxCount();
+        ComputeShader shader("shaders/init.comp", { {"SCENE", std::to_string(static_cast<int>(spec.scene))} });
+        bool poisson = spec.scene == Scene::PoissonDisc;
+
+        GLuint flags = 0, indices = 0;
+        if (poisson) {
+            flags = GpuPrimitives::createBuffer(items);
+            indices = GpuPrimitives::createBuffer(items);
+        }
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, poisson ? scratch : target);
+        if (poisson) glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, flags);
+        counter.bind();
+        setUniforms(shader, spec, items);
+        if (poisson) barriers.pass("scene candidates", {}, {scratch, flags});
+        else barriers.pass("scene", {}, {target});
+        shader.dispatch1D(items);
+
+        uint32_t count = items;
+        if (poisson) {
+            // Survivor indices, and their number straight into SimState.particleCount
+            primitives.compact(flags, items, indices, counter.buffer, 0);
+
+            ComputeShader gather("shaders/init.comp", { {"SCENE", std::to_string(static_cast<int>(spec.scene))}, {"GATHER", "1"} });
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, target);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scratch);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, indices);
+            counter.bind();
+            gather.use();
+            gather.setInt("count", static_cast<int>(items));
+            barriers.pass("scene gather", {{scratch, Usage::ShaderStorage}, {indices, Usage::ShaderStorage},
+                                           {counter.buffer, Usage::ShaderStorage}}, {target});
+            gather.dispatch1D(items);
+
+            barriers.host("scene count", counter.buffer);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, counter.buffer);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, offsetof(SimState, particleCount), sizeof(uint32_t), &count);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            glDeleteBuffers(1, &flags);
+            glDeleteBuffers(1, &indices);
+        } else {
+            counter.setCount(count);
+        }
+        return count;
+    }
+
+private:
+    BarrierTracker& barriers;
+    GpuPrimitives& primitives;
+
+    static void setUniforms(ComputeShader& shader, const SceneSpec& spec, uint32_t items) {
+        shader.use();
+        shader.setInt("count", static_cast<int>(items));
+        shader.setVec2("dimensions", spec.dimensions);
+        shader.setFloat("spacing", spec.spacing);
+        shader.setFloat("radius", spec.radius);
+        shader.setFloat("species", static_cast<float>(spec.species));
+        shader.setVec4("color", spec.color);
+        glm::ivec2 cells = spec.cells();
+        glUniform2i(glGetUniformLocation(shader.ID, "cells"), cells.x, cells.y);
+        glUniform2ui(glGetUniformLocation(shader.ID, "seed"), static_cast<GLuint>(spec.seed), static_cast<GLuint>(spec.seed >> 32));
+    }
+};
+
+#endif // SCENE_GENERATOR_H
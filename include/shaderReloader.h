@@ -0,0 +1,197 @@
+#ifndef SHADER_RELOADER_H
+#define SHADER_RELOADER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "baseShader.h"
+
+// Watches the shader directory and rebuilds programs whose sources change.
+//
+// Compilation runs on a worker thread with its own hidden GL context that shares
+// objects with the main window, so the render loop never stalls on the compiler.
+// Finished programs are handed back and swapped in by poll() on the render thread;
+// a program that fails to compile or link is discarded and the old one stays.
+//
+// Linux uses inotify; other platforms fall back to polling modification times.
+class ShaderReloader {
+public:
+    ShaderReloader(GLFWwindow* mainWindow, std::string directory)
+        : directory(std::move(directory)) {
+        // Context creation must happen on the main thread
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        workerContext = glfwCreateWindow(1, 1, "shader-reloader", nullptr, mainWindow);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if (!workerContext) {
+            std::cerr << "ShaderReloader: could not create shared context, hot reload disabled\n";
+            return;
+        }
+        worker = std::thread(&ShaderReloader::run, this);
+    }
+
+    ~ShaderReloader() { stop(); }
+
+    // Register a shader; edits to any of its source files trigger a rebuild
+    void watch(BaseShader& shader) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::string& path : shader.sourcePaths()) {
+            watched[std::filesystem::path(path).filename().string()].push_back(&shader);
+        }
+    }
+
+    // Render thread: swap in every program finished since the last call
+    void poll() {
+        std::vector<Result> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(finished);
+        }
+        for (const Result& result : done) {
+            result.shader->replaceProgram(result.program, result.variant);
+            std::cout << "\nReloaded " << result.name << "\n";
+        }
+    }
+
+    // Join the worker and release its context. Call before glfwTerminate().
+    void stop() {
+        if (!workerContext) return;
+        running = false;
+        if (worker.joinable()) worker.join();
+        glfwDestroyWindow(workerContext);
+        workerContext = nullptr;
+
+        // Programs built but never swapped in
+        for (const Result& result : finished) glDeleteProgram(result.program);
+        finished.clear();
+    }
+
+private:
+    struct Result {
+        BaseShader* shader;
+        unsigned int program;
+        std::string name;
+        std::string variant; // What the program was built for; the shader may have switched since
+    };
+
+    std::string directory;
+    GLFWwindow* workerContext = nullptr;
+    std::thread worker;
+    std::atomic<bool> running{ true };
+
+    std::mutex mutex;
+    std::map<std::string, std::vector<BaseShader*>> watched; // file name -> shaders using it
+    std::vector<Result> finished;
+
+    void run() {
+        glfwMakeContextCurrent(workerContext);
+
+#ifdef __linux__
+        int fd = inotify_init1(IN_NONBLOCK);
+        if (fd < 0 || inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            std::cerr << "ShaderReloader: inotify unavailable for " << directory << "\n";
+            if (fd >= 0) close(fd);
+            glfwMakeContextCurrent(nullptr);
+            return;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        while (running) {
+            pollfd pfd{ fd, POLLIN, 0 };
+            if (::poll(&pfd, 1, 200) <= 0) continue;
+
+            std::set<std::string> changed;
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + length;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                    if (event->len > 0) changed.insert(event->name);
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+            rebuild(changed);
+        }
+        close(fd);
+#else
+        std::map<std::string, std::filesystem::file_time_type> stamps = scan();
+        while (running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            std::map<std::string, std::filesystem::file_time_type> now = scan();
+            std::set<std::string> changed;
+            for (const auto& [name, time] : now) {
+                auto it = stamps.find(name);
+                if (it == stamps.end() || it->second != time) changed.insert(name);
+            }
+            stamps.swap(now);
+            rebuild(changed);
+        }
+#endif
+        glfwMakeContextCurrent(nullptr);
+    }
+
+    std::map<std::string, std::filesystem::file_time_type> scan() const {
+        std::map<std::string, std::filesystem::file_time_type> stamps;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+            stamps[entry.path().filename().string()] = entry.last_write_time(ec);
+        }
+        return stamps;
+    }
+
+    void rebuild(const std::set<std::string>& changed) {
+        if (changed.empty()) return;
+
+        std::set<BaseShader*> targets;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const std::string& name : changed) {
+                auto it = watched.find(name);
+                if (it != watched.end()) targets.insert(it->second.begin(), it->second.end());
+            }
+        }
+
+        for (BaseShader* shader : targets) {
+            std::string name = shader->sourcePaths().front();
+            std::vector<ShaderStage> stages;
+            std::string variant;
+            try {
+                stages = shader->loadStages(variant);
+            } catch (const std::exception& e) {
+                // Editors can briefly leave the file missing mid-save
+                std::cerr << "\nShaderReloader: " << e.what() << "\n";
+                continue;
+            }
+
+            bool ok = false;
+            unsigned int program = BaseShader::buildProgram(stages, &ok);
+            if (!ok) {
+                glDeleteProgram(program);
+                std::cerr << "ShaderReloader: keeping previous program for " << name << "\n";
+                continue;
+            }
+            // The render thread may use it as soon as it is published
+            glFinish();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.push_back({ shader, program, name, variant });
+        }
+    }
+};
+
+#endif // SHADER_RELOADER_H
@@ -0,0 +1,415 @@
+#ifndef SNAPSHOT_CODEC_H
+#define SNAPSHOT_CODEC_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cpuPrimitives.h"
+#include "crc32.h"
+#include "morton.h"
+#include "particle.h"
+#include "rans.h"
+#include "trajectory.h"
+#include "workStealingPool.h"
+
+// Compressed particle snapshots.
+//
+// Positions and velocities are quantized to 'bits' per axis over the bounds
+// of the snapshot, so the error is at most half a step of (max - min) / 2^bits.
+// Everything else (z, radius, species, colour) is kept exactly: each distinct
+// combination goes into a per-chunk palette and particles store its index.
+// That is what makes the built-in scenes, where colour follows species, about
+// 7x smaller. Scenes with a colour per particle (imported ones, say) get a
+// 32-byte palette entry per particle, and only shrink by about 1.8x.
+//
+// Particles are Morton-sorted first, so neighbours in the file are neighbours
+// in space: position deltas are a few bits and velocities of neighbours are
+// similar. The deltas are varint coded into separate streams per quantity and
+// each stream is rANS coded. Chunks are independent and coded in parallel.
+// decode() returns the particles in Morton order, not the original order.
+//
+// File layout (host byte order):
+//   Header | ChunkEntry * chunkCount | chunks
+//   chunk: StreamHeader * STREAMS | stream payloads
+namespace snapshot {
+
+constexpr uint32_t VERSION = 1;
+constexpr char MAGIC[8] = { 'F', 'L', 'U', 'I', 'D', 'S', 'N', 'P' };
+
+struct Options {
+    int positionBits = 16; // Per axis, 8..24
+    int velocityBits = 16;
+    uint32_t chunkParticles = 65536;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t particleStride; // sizeof(Particle) of the writer
+    uint32_t count;
+    uint32_t chunkCount;
+    uint8_t positionBits;
+    uint8_t velocityBits;
+    uint16_t reserved;
+    float positionMin[2];
+    float positionMax[2];
+    float velocityMin[2];
+    float velocityMax[2];
+};
+static_assert(sizeof(Header) == 60, "Snapshot header layout is part of the file format");
+
+struct ChunkEntry {
+    uint64_t offset;
+    uint32_t bytes;
+    uint32_t count;
+    uint32_t crc; // CRC-32 of the chunk bytes
+    uint32_t reserved;
+};
+static_assert(sizeof(ChunkEntry) == 24, "Snapshot chunk table layout is part of the file format");
+
+enum Stream { POSITION, VELOCITY, ATTRIBUTE_INDEX, PALETTE, STREAMS };
+enum class Method : uint32_t { Stored = 0, Rans = 1 };
+
+struct StreamHeader {
+    uint32_t rawBytes;
+    uint32_t codedBytes;
+    Method method;
+};
+
+// z, radius, vz, species, rgba as bit patterns
+using Attributes = std::array<uint32_t, 8>;
+
+struct AttributesHash {
+    size_t operator()(const Attributes& a) const {
+        uint64_t h = 14695981039346656037ull;
+        for (uint32_t v : a) h = (h ^ v) * 1099511628211ull;
+        return static_cast<size_t>(h);
+    }
+};
+
+inline Attributes attributesOf(const Particle& p) {
+    float values[8] = { p.pos_radius.z, p.pos_radius.w, p.velocity.z, p.velocity.w,
+                        p.color.r, p.color.g, p.color.b, p.color.a };
+    Attributes a;
+    std::memcpy(a.data(), values, sizeof(values));
+    return a;
+}
+
+// Maps [lo, hi] onto [0, 2^bits - 1]
+struct Quantizer {
+    double lo = 0.0;
+    double step = 0.0; // (hi - lo) / levels
+    double inverse = 0.0;
+    uint32_t levels = 0;
+
+    Quantizer(float lo, float hi, int bits) : lo(std::isfinite(lo) ? lo : 0.0f), levels((1u << bits) - 1u) {
+        step = std::isfinite(lo) && std::isfinite(hi) && hi > lo ? (static_cast<double>(hi) - lo) / levels : 0.0;
+        inverse = step > 0.0 ? 1.0 / step : 0.0;
+    }
+    // Non-finite values (a particle that blew up) map to level 0
+    uint32_t operator()(float v) const {
+        if (!std::isfinite(v) || step == 0.0) return 0;
+        double q = std::nearbyint((v - lo) * inverse);
+        return static_cast<uint32_t>(std::clamp(q, 0.0, static_cast<double>(levels)));
+    }
+    float value(uint32_t q) const { return static_cast<float>(lo + q * step); }
+};
+
+namespace detail {
+
+inline void putStream(std::vector<uint8_t>& out, const std::vector<uint8_t>& raw, StreamHeader& header) {
+    std::vector<uint8_t> coded;
+    rans::encode(raw.data(), raw.size(), coded);
+    header.rawBytes = static_cast<uint32_t>(raw.size());
+    // Incompressible streams (a palette of random colours, say) are stored as is
+    const std::vector<uint8_t>& chosen = coded.size() < raw.size() ? coded : raw;
+    header.method = coded.size() < raw.size() ? Method::Rans : Method::Stored;
+    header.codedBytes = static_cast<uint32_t>(chosen.size());
+    out.insert(out.end(), chosen.begin(), chosen.end());
+}
+
+inline void encodeChunk(const Particle* particles, const uint32_t* order, uint32_t count,
+                        const Quantizer qp[2], const Quantizer qv[2], std::vector<uint8_t>& out) {
+    std::vector<uint8_t> raw[STREAMS];
+    raw[POSITION].resize(static_cast<size_t>(count) * 10);
+    raw[VELOCITY].resize(static_cast<size_t>(count) * 10);
+    raw[ATTRIBUTE_INDEX].resize(static_cast<size_t>(count) * 5);
+    uint8_t* pos = raw[POSITION].data();
+    uint8_t* vel = raw[VELOCITY].data();
+    uint8_t* idx = raw[ATTRIBUTE_INDEX].data();
+
+    std::unordered_map<Attributes, uint32_t, AttributesHash> palette;
+    Attributes lastAttributes{};
+    uint32_t lastIndex = 0;
+    uint32_t previous[4] = {};
+    for (uint32_t i = 0; i < count; i++) {
+        const Particle& p = particles[order[i]];
+        uint32_t q[4] = { qp[0](p.pos_radius.x), qp[1](p.pos_radius.y), qv[0](p.velocity.x), qv[1](p.velocity.y) };
+        pos = trajectory::putVarint(pos, static_cast<int32_t>(q[0] - previous[0]));
+        pos = trajectory::putVarint(pos, static_cast<int32_t>(q[1] - previous[1]));
+        vel = trajectory::putVarint(vel, static_cast<int32_t>(q[2] - previous[2]));
+        vel = trajectory::putVarint(vel, static_cast<int32_t>(q[3] - previous[3]));
+        std::copy(q, q + 4, previous);
+
+        // Runs of one species are common, so skip the hash lookup for a repeat
+        Attributes a = attributesOf(p);
+        if (i == 0 || a != lastAttributes) {
+            auto [it, added] = palette.try_emplace(a, static_cast<uint32_t>(palette.size()));
+            if (added) {
+                const uint8_t* bytes = reinterpret_cast<const uint8_t*>(a.data());
+                raw[PALETTE].insert(raw[PALETTE].end(), bytes, bytes + sizeof(Attributes));
+            }
+            lastAttributes = a;
+            lastIndex = it->second;
+        }
+        idx = trajectory::putVarint(idx, static_cast<int32_t>(lastIndex));
+    }
+    raw[POSITION].resize(pos - raw[POSITION].data());
+    raw[VELOCITY].resize(vel - raw[VELOCITY].data());
+    raw[ATTRIBUTE_INDEX].resize(idx - raw[ATTRIBUTE_INDEX].data());
+
+    StreamHeader headers[STREAMS];
+    out.resize(sizeof(headers));
+    for (int s = 0; s < STREAMS; s++) putStream(out, raw[s], headers[s]);
+    std::memcpy(out.data(), headers, sizeof(headers));
+}
+
+// Stream headers consistent with 'count' particles in 'bytes' bytes: every
+// particle takes at least two bytes of position and velocity varints and one
+// of palette index
+inline bool plausibleChunk(const uint8_t* in, size_t bytes, uint32_t count) {
+    StreamHeader headers[STREAMS];
+    if (bytes < sizeof(headers)) return false;
+    std::memcpy(headers, in, sizeof(headers));
+    uint64_t coded = 0;
+    for (const StreamHeader& h : headers) {
+        if (h.rawBytes > static_cast<uint64_t>(count) * sizeof(Attributes) + 16) return false;
+        coded += h.codedBytes;
+    }
+    return coded <= bytes - sizeof(headers) &&
+           headers[POSITION].rawBytes >= 2ull * count && headers[VELOCITY].rawBytes >= 2ull * count &&
+           headers[ATTRIBUTE_INDEX].rawBytes >= count;
+}
+
+inline bool decodeChunk(const uint8_t* in, size_t bytes, uint32_t count,
+                        const Quantizer qp[2], const Quantizer qv[2], Particle* out) {
+    StreamHeader headers[STREAMS];
+    if (bytes < sizeof(headers)) return false;
+    std::memcpy(headers, in, sizeof(headers));
+    const uint8_t* p = in + sizeof(headers);
+    const uint8_t* end = in + bytes;
+
+    std::vector<uint8_t> raw[STREAMS];
+    for (int s = 0; s < STREAMS; s++) {
+        const StreamHeader& h = headers[s];
+        if (h.codedBytes > static_cast<size_t>(end - p)) return false;
+        if (h.rawBytes > static_cast<size_t>(count) * sizeof(Attributes) + 16) return false; // Beyond any valid chunk
+        raw[s].resize(h.rawBytes);
+        if (h.method == Method::Stored) {
+            if (h.codedBytes != h.rawBytes) return false;
+            if (h.rawBytes > 0) std::memcpy(raw[s].data(), p, h.rawBytes);
+        } else if (!rans::decode(p, p + h.codedBytes, raw[s].data(), h.rawBytes)) {
+            return false;
+        }
+        p += h.codedBytes;
+    }
+    if (raw[PALETTE].size() < sizeof(Attributes) && count > 0) return false;
+    uint32_t paletteSize = static_cast<uint32_t>(raw[PALETTE].size() / sizeof(Attributes));
+
+    // Every read is bounded by its stream: a damaged or crafted varint fails
+    // the chunk instead of running off the end
+    const uint8_t* pos = raw[POSITION].data();
+    const uint8_t* vel = raw[VELOCITY].data();
+    const uint8_t* idx = raw[ATTRIBUTE_INDEX].data();
+    const uint8_t* posEnd = pos + raw[POSITION].size();
+    const uint8_t* velEnd = vel + raw[VELOCITY].size();
+    const uint8_t* idxEnd = idx + raw[ATTRIBUTE_INDEX].size();
+    uint32_t q[4] = {};
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t d[4], index;
+        if (!(pos = trajectory::getVarint(pos, posEnd, d[0])) || !(pos = trajectory::getVarint(pos, posEnd, d[1])) ||
+            !(vel = trajectory::getVarint(vel, velEnd, d[2])) || !(vel = trajectory::getVarint(vel, velEnd, d[3])) ||
+            !(idx = trajectory::getVarint(idx, idxEnd, index))) {
+            return false;
+        }
+        if (static_cast<uint32_t>(index) >= paletteSize) return false;
+        for (int k = 0; k < 4; k++) q[k] += static_cast<uint32_t>(d[k]);
+
+        float values[8];
+        std::memcpy(values, raw[PALETTE].data() + static_cast<size_t>(index) * sizeof(Attributes), sizeof(values));
+        Particle& particle = out[i];
+        particle.pos_radius = glm::vec4(qp[0].value(q[0]), qp[1].value(q[1]), values[0], values[1]);
+        particle.velocity = glm::vec4(qv[0].value(q[2]), qv[1].value(q[3]), values[2], values[3]);
+        particle.color = glm::vec4(values[4], values[5], values[6], values[7]);
+    }
+    return true;
+}
+
+} // namespace detail
+
+inline std::vector<uint8_t> encode(const Particle* particles, uint32_t count, const Options& options, WorkStealingPool& pool) {
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.particleStride = sizeof(Particle);
+    header.count = count;
+    header.positionBits = static_cast<uint8_t>(std::clamp(options.positionBits, 8, 24));
+    header.velocityBits = static_cast<uint8_t>(std::clamp(options.velocityBits, 8, 24));
+    uint32_t chunkParticles = std::max(options.chunkParticles, 1u);
+    header.chunkCount = (count + chunkParticles - 1) / chunkParticles;
+
+    for (int axis = 0; axis < 2; axis++) {
+        header.positionMin[axis] = header.velocityMin[axis] = count > 0 ? INFINITY : 0.0f;
+        header.positionMax[axis] = header.velocityMax[axis] = count > 0 ? -INFINITY : 0.0f;
+    }
+    // Bounds of the finite values only; the rest quantize to level 0
+    for (uint32_t i = 0; i < count; i++) {
+        for (int axis = 0; axis < 2; axis++) {
+            float position = particles[i].pos_radius[axis], velocity = particles[i].velocity[axis];
+            if (std::isfinite(position)) {
+                header.positionMin[axis] = std::min(header.positionMin[axis], position);
+                header.positionMax[axis] = std::max(header.positionMax[axis], position);
+            }
+            if (std::isfinite(velocity)) {
+                header.velocityMin[axis] = std::min(header.velocityMin[axis], velocity);
+                header.velocityMax[axis] = std::max(header.velocityMax[axis], velocity);
+            }
+        }
+    }
+    for (int axis = 0; axis < 2; axis++) {
+        if (header.positionMin[axis] > header.positionMax[axis]) header.positionMin[axis] = header.positionMax[axis] = 0.0f;
+        if (header.velocityMin[axis] > header.velocityMax[axis]) header.velocityMin[axis] = header.velocityMax[axis] = 0.0f;
+    }
+    Quantizer qp[2] = { { header.positionMin[0], header.positionMax[0], header.positionBits },
+                        { header.positionMin[1], header.positionMax[1], header.positionBits } };
+    Quantizer qv[2] = { { header.velocityMin[0], header.velocityMax[0], header.velocityBits },
+                        { header.velocityMin[1], header.velocityMax[1], header.velocityBits } };
+
+    // Morton order on the top 16 bits of the quantized position
+    std::vector<uint32_t> keys(count), order(count);
+    int shift = header.positionBits - 16;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t x = qp[0](particles[i].pos_radius.x), y = qp[1](particles[i].pos_radius.y);
+        x = shift >= 0 ? x >> shift : x << -shift;
+        y = shift >= 0 ? y >> shift : y << -shift;
+        keys[i] = mortonSpread(x) | (mortonSpread(y) << 1);
+        order[i] = i;
+    }
+    cpu::radixSort(keys, order);
+
+    std::vector<std::vector<uint8_t>> chunks(header.chunkCount);
+    pool.parallelFor(0, header.chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t c = begin; c < end; c++) {
+            uint32_t first = c * chunkParticles;
+            detail::encodeChunk(particles, order.data() + first, std::min(chunkParticles, count - first), qp, qv, chunks[c]);
+        }
+    });
+
+    std::vector<ChunkEntry> table(header.chunkCount);
+    uint64_t offset = sizeof(Header) + table.size() * sizeof(ChunkEntry);
+    for (uint32_t c = 0; c < header.chunkCount; c++) {
+        table[c] = { offset, static_cast<uint32_t>(chunks[c].size()), std::min(chunkParticles, count - c * chunkParticles),
+                     crc32(chunks[c].data(), chunks[c].size()), 0 };
+        offset += chunks[c].size();
+    }
+    std::vector<uint8_t> out(static_cast<size_t>(offset));
+    std::memcpy(out.data(), &header, sizeof(header));
+    if (!table.empty()) std::memcpy(out.data() + sizeof(header), table.data(), table.size() * sizeof(ChunkEntry));
+    for (uint32_t c = 0; c < header.chunkCount; c++) {
+        if (!chunks[c].empty()) std::memcpy(out.data() + table[c].offset, chunks[c].data(), chunks[c].size());
+    }
+    return out;
+}
+
+inline bool isSnapshot(const uint8_t* data, size_t size) {
+    return size >= sizeof(MAGIC) && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+inline bool decode(const uint8_t* data, size_t size, std::vector<Particle>& out, WorkStealingPool& pool) {
+    Header header;
+    if (size < sizeof(header) || !isSnapshot(data, size)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != VERSION || header.particleStride != sizeof(Particle)) return false;
+    if (header.positionBits < 8 || header.positionBits > 24 || header.velocityBits < 8 || header.velocityBits > 24) return false;
+    if ((size - sizeof(header)) / sizeof(ChunkEntry) < header.chunkCount) return false;
+
+    std::vector<ChunkEntry> table(header.chunkCount);
+    if (!table.empty()) std::memcpy(table.data(), data + sizeof(header), table.size() * sizeof(ChunkEntry));
+    std::vector<uint32_t> first(header.chunkCount);
+    uint64_t total = 0;
+    for (uint32_t c = 0; c < header.chunkCount; c++) {
+        if (table[c].offset > size || table[c].bytes > size - table[c].offset) return false;
+        first[c] = static_cast<uint32_t>(total);
+        total += table[c].count;
+    }
+    if (total != header.count) return false;
+
+    Quantizer qp[2] = { { header.positionMin[0], header.positionMax[0], header.positionBits },
+                        { header.positionMin[1], header.positionMax[1], header.positionBits } };
+    Quantizer qv[2] = { { header.velocityMin[0], header.velocityMax[0], header.velocityBits },
+                        { header.velocityMin[1], header.velocityMax[1], header.velocityBits } };
+
+    // Every chunk is verified before 'out' is sized from the counts in the
+    // file, so a damaged or truncated snapshot fails instead of asking for an
+    // arbitrary allocation
+    std::vector<uint8_t> ok(header.chunkCount, 0);
+    auto allOk = [&ok] { return std::all_of(ok.begin(), ok.end(), [](uint8_t v) { return v != 0; }); };
+    pool.parallelFor(0, header.chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t c = begin; c < end; c++) {
+            ok[c] = crc32(data + table[c].offset, table[c].bytes) == table[c].crc &&
+                    detail::plausibleChunk(data + table[c].offset, table[c].bytes, table[c].count);
+        }
+    });
+    if (!allOk()) return false;
+
+    try {
+        out.resize(header.count);
+    } catch (const std::bad_alloc&) {
+        return false; // Consistent but absurd: crafted rather than damaged
+    }
+    pool.parallelFor(0, header.chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t c = begin; c < end; c++) {
+            ok[c] = detail::decodeChunk(data + table[c].offset, table[c].bytes, table[c].count, qp, qv, out.data() + first[c]);
+        }
+    });
+    return allOk();
+}
+
+inline bool save(const std::string& path, const Particle* particles, uint32_t count, const Options& options, WorkStealingPool& pool) {
+    std::vector<uint8_t> bytes = encode(particles, count, options, pool);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+        std::cerr << "Snapshot: could not write " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+inline bool load(const std::string& path, std::vector<Particle>& out, WorkStealingPool& pool) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Snapshot: could not open " << path << "\n";
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (!decode(bytes.data(), bytes.size(), out, pool)) {
+        std::cerr << "Snapshot: " << path << " is damaged or not a snapshot from this build\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace snapshot
+
+#endif // SNAPSHOT_CODEC_H
@@ -0,0 +1,96 @@
+#ifndef SPECIES_H
+#define SPECIES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+// Per-species parameters. A particle stores only its species id (velocity.w);
+// everything shared by the species lives in one small uniform block.
+struct SpeciesParams {
+    float mass = 1.0f;
+    float radius = 10.0f;       // Spawn radius; the particle keeps its own in pos_radius.w
+    float restitution = 1.0f;   // Bounciness (1.0 = elastic)
+    float pushStrength = 0.9f;  // Short-range repulsion
+    glm::vec4 color = glm::vec4(0.2f, 0.6f, 1.0f, 1.0f);
+};
+
+// std140 layout of the SpeciesTable uniform block in physics.comp. Pair terms
+// are folded on the CPU so the inner loop does one lookup per neighbour.
+struct SpeciesBlock {
+    glm::vec4 params[4];          // x = mass, y = radius, z = restitution, w = pushStrength
+    glm::vec4 color[4];
+    glm::vec4 pairPush[4];        // pushStrength_i * interaction[i][j]
+    glm::vec4 pairRestitution[4]; // min(restitution_i, restitution_j)
+};
+
+// Uploads the species table to a UBO. The shaders are specialized on the
+// species count (NUM_SPECIES): with a single species every lookup folds to a
+// constant and the id is never read.
+class SpeciesTable {
+public:
+    static constexpr int MAX_SPECIES = 4;
+    static constexpr GLuint BINDING = 0; // Uniform block binding
+
+    std::vector<SpeciesParams> species;
+    // interaction[i][j] scales the push species j exerts on species i (negative attracts)
+    float interaction[MAX_SPECIES][MAX_SPECIES];
+
+    SpeciesTable() {
+        for (auto& row : interaction) std::fill(std::begin(row), std::end(row), 1.0f);
+    }
+
+    void init() {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(SpeciesBlock), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        upload();
+        bind();
+    }
+
+    void destroy() {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+
+    // Call after editing 'species' or 'interaction'
+    void upload() {
+        SpeciesBlock block = this->block();
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SpeciesBlock), &block);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void bind() const {
+        glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer);
+    }
+
+    // The block as the shaders see it (also used by the CPU physics path)
+    SpeciesBlock block() const {
+        SpeciesBlock block{};
+        for (int i = 0; i < count(); i++) {
+            const SpeciesParams& s = species[i];
+            block.params[i] = glm::vec4(s.mass, s.radius, s.restitution, s.pushStrength);
+            block.color[i] = s.color;
+            for (int j = 0; j < count(); j++) {
+                block.pairPush[i][j] = s.pushStrength * interaction[i][j];
+                block.pairRestitution[i][j] = std::min(s.restitution, species[j].restitution);
+            }
+        }
+        return block;
+    }
+
+    int count() const { return std::min(static_cast<int>(species.size()), MAX_SPECIES); }
+
+    // Clamped like the shaders do
+    const SpeciesParams& operator[](int id) const {
+        return species[std::clamp(id, 0, count() - 1)];
+    }
+
+    GLuint buffer = 0;
+};
+
+#endif // SPECIES_H
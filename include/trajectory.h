@@ -0,0 +1,358 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mappedFile.h"
+#include "particle.h"
+
+// Recorded particle frames in one memory-mapped file.
+//
+// Layout (host byte order):
+//   Header | frame index (indexCapacity entries) | frame data ...
+// The index is an array of fixed-size entries (data offset, time, count, ...),
+// so any frame is found in O(1). When it fills up, a twice-as-large copy is
+// appended after the data and the header repointed at it.
+//
+// Frames are either raw Particle arrays or, with quantized encoding, deltas:
+// every keyframeInterval frames (and whenever the particle count or order
+// changes) a raw keyframe is written. The frames in between store position and
+// velocity, quantized to a fixed step, as zigzag varint differences from that
+// keyframe. Decoding any frame therefore reads at most two frames. Radius,
+// species and colour come from the keyframe.
+namespace trajectory {
+
+constexpr uint32_t VERSION = 1;
+constexpr char MAGIC[8] = { 'F', 'L', 'U', 'I', 'D', 'T', 'R', 'J' };
+
+enum class Encoding : uint32_t { Raw = 0, Quantized = 1 };
+enum class FrameKind : uint32_t { Raw = 0, Delta = 1 };
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t particleStride;  // sizeof(Particle) of the writer
+    Encoding encoding;
+    uint32_t keyframeInterval;
+    float positionQuantum;
+    float velocityQuantum;
+    uint64_t frameCount;      // Published last, so a cut-off file stays readable
+    uint64_t indexOffset;
+    uint64_t indexCapacity;
+    uint64_t dataEnd;
+};
+static_assert(sizeof(Header) == 64, "Trajectory header layout is part of the file format");
+
+struct IndexEntry {
+    uint64_t offset;
+    double time;
+    uint32_t count;
+    uint32_t bytes;
+    uint32_t keyframe; // Frame this one is relative to (itself for raw frames)
+    FrameKind kind;
+};
+static_assert(sizeof(IndexEntry) == 32, "Trajectory index layout is part of the file format");
+
+// Non-finite values (a particle that blew up) quantize to 0
+inline int32_t quantize(float v, float inverseQuantum) {
+    double q = std::nearbyint(static_cast<double>(v) * inverseQuantum);
+    if (!std::isfinite(q)) return 0;
+    return static_cast<int32_t>(std::clamp(q, -2147483647.0, 2147483647.0));
+}
+
+// Differences wrap modulo 2^32, so a particle far from its keyframe value
+// cannot overflow; adding the difference back wraps the same way
+inline int32_t wrappingSub(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b));
+}
+
+inline int32_t wrappingAdd(int32_t a, int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+}
+
+inline uint8_t* putVarint(uint8_t* out, int32_t value) {
+    uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    while (zigzag >= 0x80) {
+        *out++ = static_cast<uint8_t>(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(zigzag);
+    return out;
+}
+
+// Reads no further than 'end'; nullptr if the varint does not end before it
+inline const uint8_t* getVarint(const uint8_t* in, const uint8_t* end, int32_t& value) {
+    uint32_t zigzag = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (in == end) return nullptr;
+        uint8_t byte = *in++;
+        zigzag |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    value = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+    return in;
+}
+
+struct Options {
+    Encoding encoding = Encoding::Raw;
+    uint32_t keyframeInterval = 30;
+    float positionQuantum = 1.0f / 256.0f; // World units
+    float velocityQuantum = 1.0f / 256.0f; // World units per second
+};
+
+class Writer {
+public:
+    ~Writer() { close(); }
+
+    bool open(const std::string& path, const Options& options, uint64_t indexCapacity = 4096) {
+        close();
+        if (!file.open(path, MappedFile::Mode::Write)) return false;
+        this->options = options;
+        inversePosition = 1.0f / options.positionQuantum;
+        inverseVelocity = 1.0f / options.velocityQuantum;
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.particleStride = sizeof(Particle);
+        header.encoding = options.encoding;
+        header.keyframeInterval = options.keyframeInterval;
+        header.positionQuantum = options.positionQuantum;
+        header.velocityQuantum = options.velocityQuantum;
+        header.indexOffset = sizeof(Header);
+        header.indexCapacity = indexCapacity;
+        header.dataEnd = sizeof(Header) + indexCapacity * sizeof(IndexEntry);
+        if (!file.reserve(header.dataEnd)) return false;
+        std::memcpy(file.data(), &header, sizeof(header));
+        keyframe = -1;
+        return true;
+    }
+
+    // 'reordered': the caller permuted or replaced particles since the last
+    // frame, so deltas against the current keyframe would be meaningless
+    bool append(const Particle* particles, uint32_t count, double time, bool reordered = false) {
+        if (!file.isOpen()) return false;
+        Header h = header();
+        if (h.frameCount == h.indexCapacity && !growIndex(h)) return false;
+
+        uint64_t frame = h.frameCount;
+        bool delta = options.encoding == Encoding::Quantized && !reordered && keyframe >= 0 &&
+                     frame - static_cast<uint64_t>(keyframe) < options.keyframeInterval && count == keyCount &&
+                     sameIdentities(particles, count);
+
+        IndexEntry entry{};
+        entry.offset = (h.dataEnd + 15) & ~uint64_t(15); // Raw frames stay 16-byte aligned for direct upload
+        entry.time = time;
+        entry.count = count;
+        entry.kind = delta ? FrameKind::Delta : FrameKind::Raw;
+        entry.keyframe = delta ? static_cast<uint32_t>(keyframe) : static_cast<uint32_t>(frame);
+
+        size_t worstCase = delta ? static_cast<size_t>(count) * 4 * 5 : static_cast<size_t>(count) * sizeof(Particle);
+        if (!file.reserve(entry.offset + worstCase)) return false;
+        uint8_t* out = file.data() + entry.offset;
+
+        if (delta) {
+            uint8_t* p = out;
+            for (uint32_t i = 0; i < count; i++) {
+                const Particle& particle = particles[i];
+                const int32_t* key = &keyQuantized[static_cast<size_t>(i) * 4];
+                p = putVarint(p, wrappingSub(quantize(particle.pos_radius.x, inversePosition), key[0]));
+                p = putVarint(p, wrappingSub(quantize(particle.pos_radius.y, inversePosition), key[1]));
+                p = putVarint(p, wrappingSub(quantize(particle.velocity.x, inverseVelocity), key[2]));
+                p = putVarint(p, wrappingSub(quantize(particle.velocity.y, inverseVelocity), key[3]));
+            }
+            entry.bytes = static_cast<uint32_t>(p - out);
+        } else {
+            entry.bytes = count * static_cast<uint32_t>(sizeof(Particle));
+            if (entry.bytes > 0) std::memcpy(out, particles, entry.bytes);
+            if (options.encoding == Encoding::Quantized) rememberKeyframe(particles, count, frame);
+        }
+
+        // Entry first, then the count that publishes it
+        std::memcpy(file.data() + h.indexOffset + frame * sizeof(IndexEntry), &entry, sizeof(entry));
+        h.dataEnd = entry.offset + entry.bytes;
+        h.frameCount = frame + 1;
+        std::memcpy(file.data(), &h, sizeof(h));
+        return true;
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+    uint64_t frames() const { return file.isOpen() ? header().frameCount : 0; }
+    uint64_t bytes() const { return file.isOpen() ? header().dataEnd : 0; }
+
+    void close() {
+        if (!file.isOpen()) return;
+        size_t used = static_cast<size_t>(header().dataEnd);
+        file.flush();
+        file.close(used);
+    }
+
+private:
+    MappedFile file;
+    Options options;
+    float inversePosition = 256.0f;
+    float inverseVelocity = 256.0f;
+
+    // Current keyframe (quantized encoding)
+    int64_t keyframe = -1;
+    uint32_t keyCount = 0;
+    std::vector<int32_t> keyQuantized; // x, y, vx, vy per particle
+    std::vector<float> keyRadius;
+    std::vector<float> keySpecies;
+
+    Header header() const {
+        Header h;
+        std::memcpy(&h, file.data(), sizeof(h));
+        return h;
+    }
+
+    bool growIndex(Header& h) {
+        uint64_t capacity = h.indexCapacity * 2;
+        uint64_t offset = (h.dataEnd + 15) & ~uint64_t(15);
+        if (!file.reserve(offset + capacity * sizeof(IndexEntry))) return false;
+        std::memmove(file.data() + offset, file.data() + h.indexOffset, h.frameCount * sizeof(IndexEntry));
+        h.indexOffset = offset;
+        h.indexCapacity = capacity;
+        h.dataEnd = offset + capacity * sizeof(IndexEntry);
+        std::memcpy(file.data(), &h, sizeof(h));
+        return true;
+    }
+
+    void rememberKeyframe(const Particle* particles, uint32_t count, uint64_t frame) {
+        keyframe = static_cast<int64_t>(frame);
+        keyCount = count;
+        keyQuantized.resize(static_cast<size_t>(count) * 4);
+        keyRadius.resize(count);
+        keySpecies.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            const Particle& p = particles[i];
+            int32_t* key = &keyQuantized[static_cast<size_t>(i) * 4];
+            key[0] = quantize(p.pos_radius.x, inversePosition);
+            key[1] = quantize(p.pos_radius.y, inversePosition);
+            key[2] = quantize(p.velocity.x, inverseVelocity);
+            key[3] = quantize(p.velocity.y, inverseVelocity);
+            keyRadius[i] = p.pos_radius.w;
+            keySpecies[i] = p.velocity.w;
+        }
+    }
+
+    // Catches a reorder the caller did not report, unless it only swapped
+    // identical particles
+    bool sameIdentities(const Particle* particles, uint32_t count) const {
+        for (uint32_t i = 0; i < count; i++) {
+            if (particles[i].pos_radius.w != keyRadius[i] || particles[i].velocity.w != keySpecies[i]) return false;
+        }
+        return true;
+    }
+};
+
+class Reader {
+public:
+    bool open(const std::string& path) {
+        if (!file.open(path, MappedFile::Mode::Read)) return false;
+        if (file.size() < sizeof(Header)) return fail(path, "truncated");
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return fail(path, "not a trajectory");
+        if (header.version != VERSION) return fail(path, "unsupported version " + std::to_string(header.version));
+        if (header.particleStride != sizeof(Particle)) return fail(path, "particle layout differs from this build");
+        if (header.indexOffset + header.frameCount * sizeof(IndexEntry) > file.size()) return fail(path, "index out of range");
+        return true;
+    }
+
+    uint64_t frames() const { return header.frameCount; }
+
+    IndexEntry entry(uint64_t frame) const {
+        IndexEntry e;
+        std::memcpy(&e, file.data() + header.indexOffset + frame * sizeof(IndexEntry), sizeof(e));
+        return e;
+    }
+
+    // Raw frames can be used in place (e.g. uploaded straight from the mapping)
+    const Particle* rawFrame(uint64_t frame) const {
+        IndexEntry e = entry(frame);
+        if (e.kind != FrameKind::Raw) return nullptr;
+        return reinterpret_cast<const Particle*>(file.data() + e.offset);
+    }
+
+    // Largest particle count of any frame, e.g. to size upload buffers
+    uint32_t maxCount() const {
+        uint32_t count = 0;
+        for (uint64_t i = 0; i < header.frameCount; i++) count = std::max(count, entry(i).count);
+        return count;
+    }
+
+    // First frame recorded at or before 'time' (frame times only increase)
+    uint64_t frameAt(double time) const {
+        uint64_t lo = 0, hi = header.frameCount;
+        while (hi - lo > 1) {
+            uint64_t mid = (lo + hi) / 2;
+            if (entry(mid).time <= time) lo = mid; else hi = mid;
+        }
+        return lo;
+    }
+
+    // Full particle state of 'frame': one copy, plus one delta pass if needed
+    bool read(uint64_t frame, std::vector<Particle>& out) const {
+        if (frame >= header.frameCount) return false;
+        out.resize(entry(frame).count);
+        return read(frame, out.data(), static_cast<uint32_t>(out.size())) == out.size();
+    }
+
+    // Same into caller memory (any thread; the mapping is read-only). Returns
+    // the particle count, or 0 if the frame is missing, damaged or too large.
+    uint32_t read(uint64_t frame, Particle* out, uint32_t capacity) const {
+        if (frame >= header.frameCount) return 0;
+        IndexEntry e = entry(frame);
+        if (e.kind != FrameKind::Raw && e.keyframe >= header.frameCount) return 0;
+        IndexEntry key = e.kind == FrameKind::Raw ? e : entry(e.keyframe);
+        if (key.kind != FrameKind::Raw || key.count > capacity || key.count != e.count ||
+            key.offset + static_cast<uint64_t>(key.count) * sizeof(Particle) > file.size() ||
+            e.offset + e.bytes > file.size()) {
+            return 0;
+        }
+
+        std::memcpy(out, file.data() + key.offset, static_cast<size_t>(key.count) * sizeof(Particle));
+        if (e.kind == FrameKind::Raw) return e.count;
+
+        float invPos = 1.0f / header.positionQuantum;
+        float invVel = 1.0f / header.velocityQuantum;
+        // A damaged entry must not read past its own frame
+        const uint8_t* p = file.data() + e.offset;
+        const uint8_t* end = p + e.bytes;
+        for (uint32_t i = 0; i < e.count; i++) {
+            Particle& particle = out[i];
+            int32_t d[4];
+            for (int32_t& v : d) {
+                p = getVarint(p, end, v);
+                if (!p) return 0;
+            }
+            particle.pos_radius.x = static_cast<float>(wrappingAdd(quantize(particle.pos_radius.x, invPos), d[0])) * header.positionQuantum;
+            particle.pos_radius.y = static_cast<float>(wrappingAdd(quantize(particle.pos_radius.y, invPos), d[1])) * header.positionQuantum;
+            particle.velocity.x = static_cast<float>(wrappingAdd(quantize(particle.velocity.x, invVel), d[2])) * header.velocityQuantum;
+            particle.velocity.y = static_cast<float>(wrappingAdd(quantize(particle.velocity.y, invVel), d[3])) * header.velocityQuantum;
+        }
+        return e.count;
+    }
+
+    void close() { file.close(); }
+
+private:
+    MappedFile file;
+    Header header{};
+
+    bool fail(const std::string& path, const std::string& reason) {
+        std::cerr << "Trajectory: " << path << ": " << reason << "\n";
+        file.close();
+        return false;
+    }
+};
+
+} // namespace trajectory
+
+#endif // TRAJECTORY_H
@@ -0,0 +1,98 @@
+#ifndef TRAJECTORY_CAPTURE_H
+#define TRAJECTORY_CAPTURE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+#include "barrierTracker.h"
+#include "particle.h"
+#include "trajectory.h"
+
+// Feeds GPU particle state to a trajectory::Writer without stalling the frame.
+//
+// capture() copies the particle buffer into one of a few staging buffers on the
+// GPU and fences it; poll() appends every copy whose fence has signalled, in
+// order. Only when all staging buffers are still in flight does capture() wait
+// for the oldest, so every requested frame is kept and a slow disk throttles
+// the run instead of dropping frames.
+class TrajectoryCapture {
+public:
+    static constexpr int SLOTS = 3;
+
+    TrajectoryCapture(GLuint capacity, BarrierTracker& barriers, trajectory::Writer& writer)
+        : barriers(barriers), writer(writer) {
+        glGenBuffers(SLOTS, buffers);
+        for (GLuint buffer : buffers) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, capacity * sizeof(Particle), nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    ~TrajectoryCapture() {
+        poll(true);
+        glDeleteBuffers(SLOTS, buffers);
+    }
+
+    TrajectoryCapture(const TrajectoryCapture&) = delete;
+    TrajectoryCapture& operator=(const TrajectoryCapture&) = delete;
+
+    // 'reordered': see trajectory::Writer::append
+    void capture(GLuint particles, uint32_t count, double time, bool reordered) {
+        Pending& slot = pending[next];
+        if (slot.fence) drain(next, true); // Everything in flight: wait for the oldest
+
+        barriers.host("trajectory copy", particles);
+        glBindBuffer(GL_COPY_READ_BUFFER, particles);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[next]);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, count * sizeof(Particle));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.count = count;
+        slot.time = time;
+        slot.reordered = reordered;
+        next = (next + 1) % SLOTS;
+    }
+
+    // Append finished copies, oldest first; 'wait' drains everything
+    void poll(bool wait = false) {
+        for (int k = 0; k < SLOTS; k++) {
+            int slot = (next + k) % SLOTS; // Oldest first
+            if (pending[slot].fence && !drain(slot, wait)) return;
+        }
+    }
+
+private:
+    struct Pending {
+        GLsync fence = nullptr;
+        uint32_t count = 0;
+        double time = 0.0;
+        bool reordered = false;
+    };
+
+    BarrierTracker& barriers;
+    trajectory::Writer& writer;
+    GLuint buffers[SLOTS] = {};
+    Pending pending[SLOTS];
+    int next = 0;
+
+    bool drain(int slot, bool wait) {
+        Pending& p = pending[slot];
+        GLuint64 timeout = wait ? GL_TIMEOUT_IGNORED : 0;
+        if (glClientWaitSync(p.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout) == GL_TIMEOUT_EXPIRED) return false;
+        glDeleteSync(p.fence);
+        p.fence = nullptr;
+
+        glBindBuffer(GL_COPY_READ_BUFFER, buffers[slot]);
+        const void* data = p.count > 0 ? glMapBufferRange(GL_COPY_READ_BUFFER, 0, p.count * sizeof(Particle), GL_MAP_READ_BIT) : nullptr;
+        if (data || p.count == 0) writer.append(static_cast<const Particle*>(data), p.count, p.time, p.reordered);
+        if (data) glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        return true;
+    }
+};
+
+#endif // TRAJECTORY_CAPTURE_H
@@ -0,0 +1,112 @@
+#ifndef UPLOAD_RING_H
+#define UPLOAD_RING_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <vector>
+
+// Fixed-size slots the CPU fills and shaders read as SSBO ranges.
+//
+// With GL 4.4 the slots live in one persistently mapped, coherent buffer, so
+// memory(slot) is GPU-visible memory and filling a slot (from any thread) is
+// the whole upload. On 4.3 each slot gets a CPU staging copy and its own
+// buffer, and publish() uploads it with glBufferSubData. Either way the caller
+// must not touch a slot again until idle(slot) reports the GPU is done with it.
+class UploadRing {
+public:
+    void init(GLsizeiptr bytesPerSlot, int slots) {
+        GLint alignment = 256;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        stride = (std::max<GLsizeiptr>(bytesPerSlot, 16) + alignment - 1) / alignment * alignment;
+        count = slots;
+        fences.assign(slots, nullptr);
+
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        if (GLAD_GL_VERSION_4_4 && glBufferStorage) {
+            glGenBuffers(1, &storage);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, storage);
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, stride * slots, nullptr, flags);
+            mapped = static_cast<unsigned char*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, stride * slots, flags));
+            if (!mapped) {
+                glDeleteBuffers(1, &storage);
+                storage = 0;
+            }
+        }
+        if (!mapped) {
+            buffers.resize(slots);
+            staging.assign(slots, std::vector<unsigned char>(stride));
+            glGenBuffers(slots, buffers.data());
+            for (GLuint buffer : buffers) {
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+                glBufferData(GL_SHADER_STORAGE_BUFFER, stride, nullptr, GL_STREAM_DRAW);
+            }
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void destroy() {
+        for (GLsync& fence : fences) {
+            if (fence) glDeleteSync(fence);
+            fence = nullptr;
+        }
+        if (storage) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, storage);
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            glDeleteBuffers(1, &storage);
+        }
+        if (!buffers.empty()) glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+        storage = 0;
+        mapped = nullptr;
+        buffers.clear();
+        staging.clear();
+    }
+
+    bool persistent() const { return mapped != nullptr; }
+    int slots() const { return count; }
+    GLsizeiptr slotBytes() const { return stride; }
+
+    // Writable memory for 'slot'; safe from any thread while the slot is idle
+    void* memory(int slot) { return mapped ? mapped + slot * stride : staging[slot].data(); }
+
+    // GL thread, after filling: makes the first 'bytes' of the slot visible to shaders
+    void publish(int slot, GLsizeiptr bytes) {
+        if (mapped || bytes <= 0) return; // Coherent mapping: the writes are already visible
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[slot]);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, std::min(bytes, stride), staging[slot].data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void bind(int slot, GLuint index, GLsizeiptr bytes) {
+        GLsizeiptr size = std::clamp<GLsizeiptr>(bytes, 16, stride); // Empty ranges are invalid
+        if (mapped) glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, storage, slot * stride, size);
+        else glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, buffers[slot], 0, size);
+    }
+
+    // Marks the end of the GPU's use of 'slot' so far (call after the draws reading it)
+    void fence(int slot) {
+        if (fences[slot]) glDeleteSync(fences[slot]);
+        fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // Non-blocking: true once every fenced use of 'slot' has finished
+    bool idle(int slot) {
+        if (!fences[slot]) return true;
+        if (glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) return false;
+        glDeleteSync(fences[slot]);
+        fences[slot] = nullptr;
+        return true;
+    }
+
+private:
+    GLsizeiptr stride = 0;
+    int count = 0;
+    GLuint storage = 0;            // Persistent path: all slots in one buffer
+    unsigned char* mapped = nullptr;
+    std::vector<GLuint> buffers;   // Fallback path: one buffer and staging copy per slot
+    std::vector<std::vector<unsigned char>> staging;
+    std::vector<GLsync> fences;
+};
+
+#endif // UPLOAD_RING_H
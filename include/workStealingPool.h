@@ -0,0 +1,188 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool where every thread owns a deque of tasks. Owners push and pop at
+// the back (newest first, cache-warm); idle threads steal from the front of
+// other deques (oldest first, which are the largest unsplit ranges).
+//
+// parallelFor() hands out a range by recursive halving: a task keeps the left
+// half and pushes the right half onto its own deque until it is down to the
+// grain size. Uneven work (a crowded grid cell, say) therefore never pins a
+// core behind a static partition; whoever runs out steals the rest.
+//
+// The thread calling parallelFor() works too. Nested parallelFor() calls from
+// inside a task are fine.
+class WorkStealingPool {
+public:
+    // 'threads' counts the calling thread, so 1 means run everything inline
+    explicit WorkStealingPool(unsigned int threads = std::thread::hardware_concurrency()) {
+        threads = std::max(threads, 1u);
+        // One deque per worker plus one for the external caller
+        for (unsigned int i = 0; i < threads; i++) queues.push_back(std::make_unique<Queue>());
+        for (unsigned int i = 1; i < threads; i++) {
+            workers.emplace_back([this, i] { workerLoop(static_cast<int>(i)); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned int size() const { return static_cast<unsigned int>(queues.size()); }
+
+    // body(begin, end) over [begin, end) in chunks of at most 'grain' items.
+    // Returns once every chunk has run.
+    template <typename Body>
+    void parallelFor(uint32_t begin, uint32_t end, uint32_t grain, Body&& body) {
+        if (begin >= end) return;
+        grain = std::max(grain, 1u);
+        if (size() == 1 || end - begin <= grain) {
+            body(begin, end);
+            return;
+        }
+
+        // Shared with the queued halves: a task never touches the caller's
+        // frame once its items are counted, and the caller sleeps rather than
+        // spins when there is nothing left to steal
+        auto range = std::make_shared<Range>();
+        range->body = [&body](uint32_t lo, uint32_t hi) { body(lo, hi); };
+        range->grain = grain;
+        range->remaining.store(end - begin, std::memory_order_relaxed);
+        runRange(range, begin, end);
+
+        // Help out until every item is done
+        int self = currentIndex();
+        while (range->remaining.load(std::memory_order_acquire) > 0) {
+            if (runOne(self)) continue;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [&] {
+                return range->remaining.load(std::memory_order_acquire) == 0 || queued.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // One parallelFor() call
+    struct Range {
+        std::function<void(uint32_t, uint32_t)> body;
+        uint32_t grain = 1;
+        std::atomic<uint32_t> remaining{ 0 };
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> queued{ 0 };
+    bool stopping = false;
+
+    // The pool a worker thread belongs to, and its index there
+    struct Worker {
+        const WorkStealingPool* pool = nullptr;
+        int index = 0;
+    };
+
+    static Worker& currentWorker() {
+        static thread_local Worker worker;
+        return worker;
+    }
+
+    // Worker i uses deque i; any other thread, including a worker of another
+    // pool, shares deque 0
+    int currentIndex() const {
+        const Worker& worker = currentWorker();
+        return worker.pool == this ? worker.index : 0;
+    }
+
+    void push(std::function<void()> task) {
+        Queue& queue = *queues[currentIndex()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1, std::memory_order_release);
+        // Taking the lock orders this against a worker between its check and its wait
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wake.notify_one();
+    }
+
+    // Splits until 'grain', queueing right halves where thieves can see them
+    void runRange(const std::shared_ptr<Range>& range, uint32_t lo, uint32_t hi) {
+        while (hi - lo > range->grain) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            push([this, range, mid, hi] { runRange(range, mid, hi); });
+            hi = mid;
+        }
+        range->body(lo, hi);
+        // The decrement that reaches zero is the last use of the caller's state
+        if (range->remaining.fetch_sub(hi - lo, std::memory_order_acq_rel) == hi - lo) {
+            { std::lock_guard<std::mutex> lock(sleepMutex); }
+            wake.notify_all();
+        }
+    }
+
+    // Own deque from the back, then everyone else's from the front
+    bool runOne(int self) {
+        std::function<void()> task;
+        {
+            Queue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+            }
+        }
+        int count = static_cast<int>(queues.size());
+        for (int k = 1; !task && k < count; k++) {
+            Queue& victim = *queues[(self + k) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+        if (!task) return false;
+
+        queued.fetch_sub(1, std::memory_order_acq_rel);
+        task();
+        return true;
+    }
+
+    void workerLoop(int index) {
+        currentWorker() = { this, index };
+        while (true) {
+            if (runOne(index)) continue;
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+            if (stopping) return;
+        }
+    }
+};
+
+#endif // WORK_STEALING_POOL_H
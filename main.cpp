@@ -14,9 +14,36 @@
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <csignal>
+#include <filesystem>
 
 #include "computeShader.h" 
 #include "shader.h" 
+#include "particleStore.h"
+#include "barrierTracker.h"
+#include "shaderReloader.h"
+#include "autotuner.h"
+#include "particle.h"
+#include "morton.h"
+#include "gpuPrimitives.h"
+#include "mortonSorter.h"
+#include "diagnostics.h"
+#include "fieldTiles.h"
+#include "species.h"
+#include "obstacles.h"
+#include "cpuPhysics.h"
+#include "workStealingPool.h"
+#include "philox.h"
+#include "checkpoint.h"
+#include "trajectory.h"
+#include "trajectoryCapture.h"
+#include "replayPlayer.h"
+#include "snapshotCodec.h"
+#include "sceneGenerator.h"
+#include "particleImporter.h"
 
 
 
@@ -30,30 +57,55 @@ float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 float radius = 1.0f;
-bool resendData = false; 
 bool pressed = false;
-
-constexpr uint32_t MAX_PARTICLES = 10000;
+bool pushEnabled = true;       // C toggles: compiled out of physics.comp when off
+bool collisionsEnabled = true; // V toggles
+bool periodicBoundary = false; // B toggles: wrap-around domain instead of walls
+bool deterministic = false;    // --deterministic: seeded RNG, fixed timestep, exact CPU sums
+bool checkpointRequested = false; // K, or the interval; written at the next frame boundary
+volatile std::sig_atomic_t terminateRequested = 0; // SIGTERM: checkpoint, then exit
+double simTime = 0.0;          // Simulated seconds since the run (not this process) started
+unsigned int gravityWorkgroupSize = 256; // Replaced by the autotuned size for this device
+unsigned int physicsWorkgroupSize = 256;
+
+constexpr uint32_t MAX_PARTICLES = 10000;   // Capacity, unless a --load scene needs more
+constexpr uint32_t LOAD_HEADROOM = 10000;   // Room left for emitting into a loaded scene
 constexpr uint32_t INITIAL_PARTICLES = 500;
 constexpr float GRAVITY = 0.0f;       // Global downward gravity (if needed)
 float GRAVITY_CONSTANT = 25.0f; // Interaction strength
+constexpr bool VALIDATE_BARRIERS = false; // Log every barrier and report SSBO hazards
+constexpr bool HOT_RELOAD_SHADERS = true;  // Rebuild shaders/ on save without restarting
+constexpr int MORTON_SORT_INTERVAL = 30;   // Frames between spatial re-sorts (0 = never)
+constexpr int DIAGNOSTICS_INTERVAL = 120;  // Frames between energy/momentum samples (0 = never)
+constexpr bool SPARSE_FIELD = true;        // Only evaluate field tiles some particle reaches
+constexpr bool DEFAULT_OBSTACLES = true;   // Built-in shapes when no --obstacles mask is given
+constexpr int HEADLESS_STEPS = 600;        // Frames simulated by --headless unless --steps is given
+constexpr float FIXED_TIMESTEP = 1.0f / 60.0f; // Frame time in deterministic mode and headless runs
+constexpr uint64_t DEFAULT_SEED = 1;       // Deterministic mode without --seed
+constexpr int CHECKPOINT_INTERVAL = 3600;  // Frames between automatic checkpoints (0 = never)
+constexpr const char* CHECKPOINT_PATH = "checkpoint.bin"; // Unless --checkpoint PATH is given
+constexpr int TRAJECTORY_KEYFRAME_INTERVAL = 30; // Frames per keyframe with --record-quantized
 
 GLFWwindow* window;
 
-struct alignas(16) Particle {
-    glm::vec4 pos_radius; // x,y,z, radius
-    glm::vec4 velocity; 
-    glm::vec4 color;
-};
-
 // Global Vectors
-std::vector<Particle> particles;
+std::vector<Particle> initialParticles; // Grid, --load or --resume scene until initSSBOs uploads it; --headless state
 std::vector<glm::vec2> fields;
 
 // OpenGL IDs
 unsigned int VAO, VBO, bgVAO, bgVBO;
-GLuint particlesSSBO[2];
+ParticleStore particleStore; // Particle ring + live count; the only copy of the particles
 GLuint fieldSSBO;
+BarrierTracker barriers;
+SpeciesTable speciesTable; // Mass, radius, restitution, push per species (UBO)
+ObstacleField obstacles;   // Static obstacles as a signed distance texture
+PhiloxStream rng;          // All host-side randomness
+std::string checkpointPath = CHECKPOINT_PATH;
+int checkpointInterval = CHECKPOINT_INTERVAL;
+trajectory::Writer trajectoryWriter; // --record PATH
+int recordInterval = 1;              // --record-every N
+bool compressSnapshots = false;      // --compress-snapshots: dumps go through the snapshot codec
+snapshot::Options snapshotOptions;   // --snapshot-bits N
 
 // ---------------------------------------------------------
 // 2. Helper Declarations
@@ -62,21 +114,109 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void initWindow();
 void initGeometry();
-void initSSBOs();
+void initSSBOs(bool sortParticles = true, uint32_t minimumCount = 0);
 glm::vec4 randomColour();
 glm::vec4 randomDirection2D();
-void circle(float x, float y, float r);
-void dumpParticlesToFile(GLuint particlesSSBO, size_t particleCount, const std::string& filename);
+void initSpecies();
+bool initObstacles(int argc, char** argv);
+Particle makeParticle(float x, float y, int species = 0);
+void circle(float x, float y, int species = 0);
+void dumpParticlesToFile(const Particle* gpuParticles, size_t particleCount, const std::string& filename);
+void dumpParticles(const Particle* gpuParticles, size_t particleCount, WorkStealingPool* pool = nullptr);
 void initParticles();
+ComputeShader::Defines physicsDefines();
+void autotuneComputePasses(ComputeShader& gravityShader, ComputeShader& physicsShader, bool force, bool verbose);
+bool hasArg(int argc, char** argv, const char* name);
+const char* argValue(int argc, char** argv, const char* name);
+int runHeadless(int argc, char** argv, const Checkpoint* resumed);
+bool openTrajectory(int argc, char** argv);
+bool loadParticles(const char* path);
+bool parseScene(int argc, char** argv, SceneSpec& spec);
+int runReplay(const char* path, int argc, char** argv);
+void processReplayInput(GLFWwindow* window, ReplayPlayer& player);
+uint64_t stateHash(const std::vector<Particle>& state);
+void onTerminate(int signal);
+Checkpoint hostCheckpoint(long long frame);
+void restoreCheckpoint(const Checkpoint& checkpoint);
+void saveGpuCheckpoint(long long frame);
 
 // ---------------------------------------------------------
 // 3. Main
 // ---------------------------------------------------------
-int main()
+int main(int argc, char** argv)
 {
-    srand(static_cast <unsigned> (time(0)));
+    // --deterministic [--seed N]: identical runs for identical arguments
+    deterministic = hasArg(argc, argv, "--deterministic");
+    uint64_t seed = deterministic ? DEFAULT_SEED : static_cast<uint64_t>(time(0));
+    if (const char* value = argValue(argc, argv, "--seed")) seed = std::strtoull(value, nullptr, 10);
+    rng = PhiloxStream(seed);
+
+    // --checkpoint PATH, --checkpoint-every N (frames), --resume
+    if (const char* value = argValue(argc, argv, "--checkpoint")) checkpointPath = value;
+    if (const char* value = argValue(argc, argv, "--checkpoint-every")) checkpointInterval = std::max(0, std::atoi(value));
+    std::signal(SIGTERM, onTerminate);
+
+    // Restores particles, toggles, RNG and time; only the GL objects are rebuilt
+    Checkpoint resumed;
+    bool resuming = hasArg(argc, argv, "--resume");
+    if (resuming) {
+        if (!resumed.load(checkpointPath)) return 1;
+        // A checkpoint's past cannot be made reproducible after the fact
+        if (deterministic && !resumed.deterministic) {
+            std::cerr << checkpointPath << " was not written by a --deterministic run; resume without --deterministic\n";
+            return 1;
+        }
+        if (!deterministic && resumed.deterministic) {
+            std::cout << "Resuming in deterministic mode, as " << checkpointPath << " was written\n";
+        }
+        restoreCheckpoint(resumed);
+        std::cout << "Resuming " << checkpointPath << " at frame " << resumed.frame << " (" << initialParticles.size() << " particles)\n";
+    }
+
+    // Plays a --record file back instead of simulating
+    if (const char* path = argValue(argc, argv, "--replay")) return runReplay(path, argc, argv);
+
+    initSpecies(); // Before the shaders: physics is specialized on the species count
+    if (!initObstacles(argc, argv)) return 1; // Likewise on whether there are obstacles
+    if (!openTrajectory(argc, argv)) return 1;
+
+    // --compress-snapshots [--snapshot-bits N]: P and --headless dumps are
+    // written as particle_dump.snap, quantized to N bits per axis
+    compressSnapshots = hasArg(argc, argv, "--compress-snapshots");
+    if (const char* value = argValue(argc, argv, "--snapshot-bits")) {
+        snapshotOptions.positionBits = snapshotOptions.velocityBits = std::atoi(value);
+    }
+
+    // --load PATH: start from a CSV dump, a snapshot or a raw Particle array
+    // instead of the built-in grid (ignored when resuming)
+    if (const char* path = argValue(argc, argv, "--load")) {
+        if (!resuming && !loadParticles(path)) return 1;
+    }
+
+    // --scene NAME [--scene-count N] [--scene-spacing S] [--scene-species N]:
+    // build the initial scene on the GPU instead (ignored when resuming or loading)
+    SceneSpec sceneSpec;
+    bool generateScene = false;
+    if (argValue(argc, argv, "--scene") && !resuming && initialParticles.empty()) {
+        if (!parseScene(argc, argv, sceneSpec)) return 1;
+        generateScene = true;
+    }
+
+    // CPU simulation only: no window, no GL
+    if (hasArg(argc, argv, "--headless")) {
+        if (generateScene) {
+            std::cerr << "--scene runs on the GPU; use --load for headless runs\n";
+            return 1;
+        }
+        return runHeadless(argc, argv, resuming ? &resumed : nullptr);
+    }
 
     initWindow();
+    speciesTable.init();
+    if (!obstacles.empty()) {
+        obstacles.upload();
+        obstacles.bind();
+    }
     
     // --- Shaders ---
     // Make sure your classes are set up to handle these paths
@@ -84,26 +224,113 @@ int main()
     GraphicsShader bgShader("shaders/background.vert", "shaders/background.frag");
     
     // Create distinct objects for distinct tasks
-    ComputeShader gravityShader("shaders/gravity.comp"); // Calculates field
-    ComputeShader physicsShader("shaders/physics.comp"); // Moves particles
+    ComputeShader gravityShader("shaders/gravity.comp", { {"WORKGROUP_SIZE", std::to_string(gravityWorkgroupSize)} }); // Calculates field
+    ComputeShader gravityTilesShader("shaders/gravity.comp", { {"SPARSE_TILES", "1"},
+                                     {"TILE_SIZE", std::to_string(FieldTiles::TILE_SIZE)} }); // Field, active tiles only
+    ComputeShader physicsShader("shaders/physics.comp", physicsDefines());              // Moves particles
+    ComputeShader emitShader("shaders/emit.comp");                                      // Appends a particle
+    ComputeShader argsShader("shaders/indirectArgs.comp");                              // Count -> indirect args
+
+    // Edits to any of these recompile in the background and swap in next frame
+    std::unique_ptr<ShaderReloader> reloader;
+    if (HOT_RELOAD_SHADERS) {
+        reloader = std::make_unique<ShaderReloader>(window, "shaders");
+        reloader->watch(shader);
+        reloader->watch(bgShader);
+        reloader->watch(gravityShader);
+        reloader->watch(gravityTilesShader);
+        reloader->watch(physicsShader);
+        reloader->watch(emitShader);
+        reloader->watch(argsShader);
+    }
 
     // --- Data Setup ---
     initGeometry();
 
-    initParticles();
+    if (!resuming && initialParticles.empty() && !generateScene) initParticles();
 
     // Init Field (Grid) - Initialize to 0
     fields.resize(SCR_WIDTH * SCR_HEIGHT, glm::vec2(0.0f));
 
-    initSSBOs();
+    initSSBOs(!resuming, generateScene ? sceneSpec.maxCount() : 0); // A resumed run keeps the saved order, so it continues bit for bit
+    barriers.validate = VALIDATE_BARRIERS;
+
+    // --- Workgroup Sizes ---
+    // Tuned on first launch for this device; --autotune re-tunes, --benchmark
+    // re-tunes with a full timing table and exits.
+    bool benchmark = hasArg(argc, argv, "--benchmark");
+    autotuneComputePasses(gravityShader, physicsShader, benchmark || hasArg(argc, argv, "--autotune"), benchmark);
+    if (benchmark) {
+        reloader.reset(); // Its worker holds a context that must go before GLFW does
+        particleStore.destroy();
+        speciesTable.destroy();
+        obstacles.destroy();
+        glDeleteBuffers(1, &fieldSSBO);
+        glfwTerminate();
+        return 0;
+    }
+
+    // Shared scan / sort / compaction kernels; --selftest checks them against the CPU
+    auto gpuPrimitives = std::make_unique<GpuPrimitives>(particleStore.capacity(), barriers);
+    if (hasArg(argc, argv, "--selftest")) {
+        std::cout << "GPU primitives self-test\n";
+        bool ok = gpuPrimitives->selfTest();
+        gpuPrimitives.reset();
+        reloader.reset();
+        particleStore.destroy();
+        speciesTable.destroy();
+        obstacles.destroy();
+        glDeleteBuffers(1, &fieldSSBO);
+        glfwTerminate();
+        return ok ? 0 : 1;
+    }
+
+    // Written straight into the presented slot; the slot after it holds the
+    // Poisson-disc candidates until the first step overwrites it
+    if (generateScene) {
+        auto start = std::chrono::steady_clock::now();
+        int scratchSlot = particleStore.ring.acquire(particleStore.ring.presented());
+        particleStore.setCount(SceneGenerator(barriers, *gpuPrimitives).generate(sceneSpec, particleStore.ring.presentedBuffer(),
+                                                                                 particleStore.ring.buffer(scratchSlot), particleStore.counter));
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Scene: " << argValue(argc, argv, "--scene") << ", " << particleStore.count() << " particles in " << std::fixed
+                  << std::setprecision(1) << seconds * 1000.0 << " ms" << std::defaultfloat << "\n";
+    }
+
+    // Periodic Z-order reordering for cache locality in the neighbour loops
+    std::unique_ptr<MortonSorter> mortonSorter;
+    if (MORTON_SORT_INTERVAL > 0) {
+        mortonSorter = std::make_unique<MortonSorter>(particleStore.capacity(), barriers, *gpuPrimitives);
+    }
+
+    // Energy / momentum / bounds, reduced on the GPU and logged to diagnostics.csv
+    std::unique_ptr<Diagnostics> diagnostics;
+    if (DIAGNOSTICS_INTERVAL > 0) diagnostics = std::make_unique<Diagnostics>(particleStore.capacity(), barriers);
+
+    // Every Nth frame of particle state appended to the --record file
+    std::unique_ptr<TrajectoryCapture> trajectoryCapture;
+    if (trajectoryWriter.isOpen()) {
+        trajectoryCapture = std::make_unique<TrajectoryCapture>(particleStore.capacity(), barriers, trajectoryWriter);
+    }
+    bool reorderedSinceCapture = true;
+
+    // Tile occupancy over the field grid, sized once like the field itself
+    std::unique_ptr<FieldTiles> fieldTiles;
+    if (SPARSE_FIELD) {
+        fieldTiles = std::make_unique<FieldTiles>(SCR_WIDTH, SCR_HEIGHT, particleStore.capacity(), barriers);
+        if (reloader) reloader->watch(fieldTiles->shader());
+    }
 
-    // --- Ping-Pong State ---
-    int readIndex = 0;  // Frame N
-    int writeIndex = 1; // Frame N+1
+    // --- Ring State ---
+    // The presented slot holds frame N; frame N+1 is simulated into the other slots
+    // so its dispatches can be queued while frame N is still being drawn.
 
     // --- Render Loop ---
     float fpsTimer = 0.0f;
     int fpsFrameCount = 0;
+    long long frameIndex = resuming ? static_cast<long long>(resumed.frame) : 0;
+    long long lastCheckpoint = frameIndex;
 
     while (!glfwWindowShouldClose(window))
     {
@@ -116,97 +343,96 @@ int main()
         fpsTimer += deltaTime;
         fpsFrameCount++;
         if (fpsTimer >= 1.0f) {
-            std::cout << "FPS: " << fpsFrameCount << " | Particles: " << particles.size() << " | Gravity Constant: " << GRAVITY_CONSTANT << "\r";
+            auto [barrierCount, passCount] = barriers.takeStats();
+            std::cout << "FPS: " << fpsFrameCount << " | Particles: " << particleStore.count() << " | Gravity Constant: " << GRAVITY_CONSTANT
+                      << " | Barriers/frame: " << barrierCount / fpsFrameCount << "/" << passCount / fpsFrameCount << "\r";
             std::cout.flush();
             fpsTimer = 0.0f;
             fpsFrameCount = 0;
         }
 
         processInput(window);
+        if (reloader) reloader->poll();
         if (SCR_WIDTH == 0 || SCR_HEIGHT == 0) { glfwWaitEvents(); continue; }
 
         // ---------------------------------------------------------
         // 1. DATA UPLOAD (Only if new particles added)
         // ---------------------------------------------------------
-        if (resendData) {
-            int newIndex = static_cast<int>(particles.size()) - 1;
-            GLintptr offset = newIndex * sizeof(Particle);
-            
-            // Upload to BOTH buffers to prevent flickering
-            for (int i = 0; i < 2; i++) {
-                glBindBuffer(GL_SHADER_STORAGE_BUFFER, particlesSSBO[i]);
-                glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, sizeof(Particle), &particles[newIndex]);
-            }
-            resendData = false;
+        particleStore.counter.bind();
+        // Appended on the GPU at the live count. Only the presented slot needs
+        // them: every physics step copies all live particles forward into the
+        // slot it writes.
+        particleStore.emitPending([&](const Particle& newParticle) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleStore.ring.presentedBuffer());
+            emitShader.use();
+            emitShader.setVec4("posRadius", newParticle.pos_radius);
+            emitShader.setVec4("velocity", newParticle.velocity);
+            emitShader.setVec4("color", newParticle.color);
+            emitShader.setInt("capacity", (int)particleStore.capacity());
+            barriers.pass("emit", {{particleStore.counter.buffer, Usage::ShaderStorage}}, {particleStore.ring.presentedBuffer(), particleStore.counter.buffer});
+            emitShader.dispatch(1, 1, 1);
+        });
+
+        // Checkpoint at the frame boundary: the presented slot holds frame
+        // 'frameIndex' and nothing of the next frame has been queued yet
+        if (checkpointInterval > 0 && frameIndex % checkpointInterval == 0 && frameIndex != lastCheckpoint) {
+            checkpointRequested = true;
+        }
+        if (checkpointRequested || terminateRequested) {
+            saveGpuCheckpoint(frameIndex);
+            lastCheckpoint = frameIndex;
+            checkpointRequested = false;
+            if (terminateRequested) break;
         }
 
-        // ---------------------------------------------------------
-        // 2. BIND BUFFERS (The Swap Logic)
-        // ---------------------------------------------------------
-        // Binding 0 = Input (Read Old Frame)
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particlesSSBO[readIndex]);
-        // Binding 1 = Output (Write New Frame)
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, particlesSSBO[writeIndex]);
-        // Binding 3 = Field Data (Read/Write)
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, fieldSSBO);
-
-
-        // ---------------------------------------------------------
-        // 3. COMPUTE PASS 1: Gravity Field
-        // ---------------------------------------------------------
-        // This shader runs for every pixel (grid cell) to calculate the field
-        gravityShader.use();
-        gravityShader.setVec2("dimensions", (float)SCR_WIDTH, (float)SCR_HEIGHT);
-        gravityShader.setInt("numParticles", (int)particles.size());
-        gravityShader.setFloat("gravityConstant", GRAVITY_CONSTANT);
-        gravityShader.setInt("numFields", (int)fields.size());
-
-        // Dispatch based on GRID SIZE (Width * Height)
-        // Group size is usually 256 in X.
-        unsigned int totalPixels = (unsigned int)fields.size();
-        gravityShader.dispatch((totalPixels + 255) / 256, 1, 1);
-        
-        // Wait for field calculations to finish before physics uses them
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-
-        // ---------------------------------------------------------
-        // 4. COMPUTE PASS 2: Particle Physics
-        // ---------------------------------------------------------
-        // This shader runs for every particle to move it
-        physicsShader.use();
-        
-        physicsShader.setInt("numParticles", (int)particles.size());
-        physicsShader.setFloat("gravity", GRAVITY);
-        physicsShader.setVec2("dimensions", (float)SCR_WIDTH, (float)SCR_HEIGHT);
-        physicsShader.setInt("numFields", (int)fields.size());
-        physicsShader.setFloat("gravityConstant", GRAVITY_CONSTANT);
+        if (trajectoryCapture) {
+            if (frameIndex % recordInterval == 0) {
+                trajectoryCapture->capture(particleStore.ring.presentedBuffer(), particleStore.count(),
+                                           simTime, reorderedSinceCapture);
+                reorderedSinceCapture = false;
+            }
+            trajectoryCapture->poll();
+        }
 
-        unsigned int totalParticles = (unsigned int)particles.size();
-        //substeps
-        int numSubsteps = 4;
-        for (int i = 0; i < numSubsteps; i++) {
-            physicsShader.setFloat("deltaTime", deltaTime / (float)numSubsteps);
-            physicsShader.dispatch((totalParticles + 255) / 256, 1, 1);
-            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-            std::swap(readIndex, writeIndex);
+        // Spatial re-sort into a free slot, which then becomes the presented one
+        if (mortonSorter && frameIndex % MORTON_SORT_INTERVAL == 0) {
+            int sortedSlot = particleStore.ring.acquire(particleStore.ring.presented());
+            mortonSorter->sort(particleStore.ring.presentedBuffer(), particleStore.ring.buffer(sortedSlot),
+                               particleStore.counter.buffer, glm::vec2(SCR_WIDTH, SCR_HEIGHT));
+            particleStore.ring.present(sortedSlot);
+            particleStore.counter.bind(); // The sort used bindings 0-4
+            reorderedSinceCapture = true;
         }
+        frameIndex++;
 
+        // Indirect physics dispatch + particle draw sized from the GPU count
+        argsShader.use();
+        argsShader.setInt("physicsWorkgroupSize", (int)physicsShader.workgroupSize());
+        argsShader.setInt("verticesPerParticle", 6);
+        barriers.pass("indirect args", {{particleStore.counter.buffer, Usage::ShaderStorage}}, {particleStore.counter.buffer});
+        argsShader.dispatch(1, 1, 1);
 
         // ---------------------------------------------------------
-        // 5. RENDER STEP
+        // 2. RENDER STEP (Frame N, the presented slot)
         // ---------------------------------------------------------
+        // Drawn before the simulation is queued: the next step only reads the
+        // presented slot, so the driver is free to overlap the two.
         glClear(GL_COLOR_BUFFER_BIT);
         glm::mat4 projection = glm::ortho(-(float)SCR_WIDTH / 2.0f, (float)SCR_WIDTH / 2.0f, -(float)SCR_HEIGHT / 2.0f, (float)SCR_HEIGHT / 2.0f);
 
         // A. Draw Background (Heatmap)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, fieldSSBO);
         bgShader.use();
         bgShader.setVec2("dimensions", (float)SCR_WIDTH, (float)SCR_HEIGHT);
         bgShader.setFloat("fieldScale", 0.01f); // Adjust this to make heatmap brighter/dimmer
+        bgShader.setInt("showObstacles", obstacles.empty() ? 0 : 1);
+        obstacles.bind();
         
         glm::mat4 model = glm::scale(glm::mat4(1.0f), glm::vec3(SCR_WIDTH, SCR_HEIGHT, 1.0f));
         bgShader.setMat4("uModel", model);
         bgShader.setMat4("uProjection", projection);
         
+        barriers.pass("background", {{fieldSSBO, Usage::ShaderStorage}});
         glBindVertexArray(bgVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
@@ -214,44 +440,140 @@ int main()
         shader.use();
         shader.setMat4("projection", projection);
         
-        // CRITICAL: Bind the *writeIndex* buffer to Binding 0 for the vertex shader
-        // The vertex shader reads from Binding 0 to get the *latest* positions.
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particlesSSBO[writeIndex]);
+        // The vertex shader reads from Binding 0 to get the presented positions.
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleStore.ring.presentedBuffer());
         
+        barriers.pass("particles", {{particleStore.ring.presentedBuffer(), Usage::ShaderStorage},
+                                    {particleStore.counter.buffer, Usage::Command}});
         glBindVertexArray(VAO);
-        if (!particles.empty()) {
-            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(particles.size()));
-        }
+        particleStore.counter.drawIndirect(GL_TRIANGLES);
 
-        // ---------------------------------------------------------
-        // 6. SWAP & SNAPSHOT
-        // ---------------------------------------------------------
-        
-        // Handle Screenshot (Dump)
+        // C. Snapshot (Dump)
+        // Pins the slot we just drew; it is written out once its fence signals,
+        // a frame or two later, without stalling on the GPU.
         if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
-            if (!pressed) {
-                // Dump the buffer we just wrote to
-                dumpParticlesToFile(particlesSSBO[writeIndex], particles.size(), "particle_dump.csv");
+            if (!pressed && !particleStore.downloadPending()) {
+                barriers.host("readback", particleStore.ring.presentedBuffer());
+                particleStore.requestDownload();
                 pressed = true;
             }
         } else {
             pressed = false;
         }
+        particleStore.pollDownload([](const Particle* data, uint32_t count) {
+            dumpParticles(data, count);
+        });
+
+        // D. Diagnostics
+        // Reduces the presented slot; the result is logged once its fence signals.
+        if (diagnostics) {
+            if (frameIndex % DIAGNOSTICS_INTERVAL == 0) {
+                diagnostics->sample(particleStore.ring.presentedBuffer(), particleStore.counter.buffer, frameIndex, simTime);
+            }
+            diagnostics->poll();
+        }
+
+        // ---------------------------------------------------------
+        // 3. COMPUTE PASS 1: Gravity Field (Frame N+1)
+        // ---------------------------------------------------------
+        // This shader runs for every pixel (grid cell) to calculate the field
+        int readSlot = particleStore.ring.presented();
+        // The boundary mode picks the variant of every pass that measures distances
+        std::string periodicDefine = periodicBoundary ? "1" : "0";
+        if (fieldTiles) {
+            fieldTiles->shader().setDefine("PERIODIC_BOUNDARY", periodicDefine);
+            // Only tiles within some particle's kernel support; the rest is cleared
+            fieldTiles->build(particleStore.ring.buffer(readSlot), particleStore.counter.buffer, glm::vec2(SCR_WIDTH, SCR_HEIGHT));
+            barriers.host("field clear", fieldSSBO);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, fieldSSBO);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_RG32F, GL_RG, GL_FLOAT, nullptr);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+        // Binding 0 = Input (Read Old Frame)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleStore.ring.buffer(readSlot));
+        // Binding 3 = Field Data (Read/Write)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, fieldSSBO);
 
-        // Swap indices for next frame
-        // Read becomes Write, Write becomes Read
-        std::swap(readIndex, writeIndex);
+        ComputeShader& fieldShader = fieldTiles ? gravityTilesShader : gravityShader;
+        fieldShader.setDefine("PERIODIC_BOUNDARY", periodicDefine);
+        fieldShader.use();
+        fieldShader.setVec2("dimensions", (float)SCR_WIDTH, (float)SCR_HEIGHT);
+        fieldShader.setFloat("gravityConstant", GRAVITY_CONSTANT);
+        fieldShader.setInt("numFields", (int)fields.size());
+
+        if (fieldTiles) {
+            fieldShader.setInt("tilesX", fieldTiles->tilesX);
+            barriers.pass("gravity", {{particleStore.ring.buffer(readSlot), Usage::ShaderStorage},
+                                      {particleStore.counter.buffer, Usage::ShaderStorage},
+                                      {fieldTiles->list, Usage::ShaderStorage},
+                                      {fieldTiles->list, Usage::Command}}, {fieldSSBO});
+            fieldTiles->dispatchIndirect();
+        } else {
+            // Dispatch based on GRID SIZE (Width * Height)
+            unsigned int totalPixels = (unsigned int)fields.size();
+            barriers.pass("gravity", {{particleStore.ring.buffer(readSlot), Usage::ShaderStorage},
+                                      {particleStore.counter.buffer, Usage::ShaderStorage}}, {fieldSSBO});
+            fieldShader.dispatch1D(totalPixels);
+        }
+        // No barrier here: physics does not read the field. The background draw
+        // that does picks up its barrier next frame.
 
+        // ---------------------------------------------------------
+        // 4. COMPUTE PASS 2: Particle Physics
+        // ---------------------------------------------------------
+        // This shader runs for every particle to move it
+        // Feature toggles select a specialized variant (built once, then cached)
+        physicsShader.setDefines(physicsDefines());
+        physicsShader.use();
+        
+        physicsShader.setFloat("gravity", GRAVITY);
+        physicsShader.setVec2("dimensions", (float)SCR_WIDTH, (float)SCR_HEIGHT);
+        physicsShader.setInt("numFields", (int)fields.size());
+        physicsShader.setFloat("gravityConstant", GRAVITY_CONSTANT);
+        physicsShader.setVec2("sdfWorldSize", obstacles.worldSize);
+
+        //substeps
+        int numSubsteps = 4;
+        float frameTime = deterministic ? FIXED_TIMESTEP : deltaTime; // Wall clock is never reproducible
+        for (int i = 0; i < numSubsteps; i++) {
+            int writeSlot = particleStore.ring.acquire(readSlot);
+            // Binding 0 = Input, Binding 1 = Output
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleStore.ring.buffer(readSlot));
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, particleStore.ring.buffer(writeSlot));
+
+            physicsShader.setFloat("deltaTime", frameTime / (float)numSubsteps);
+            barriers.pass("physics", {{particleStore.ring.buffer(readSlot), Usage::ShaderStorage},
+                                      {particleStore.counter.buffer, Usage::ShaderStorage},
+                                      {particleStore.counter.buffer, Usage::Command}}, {particleStore.ring.buffer(writeSlot)});
+            particleStore.counter.dispatchIndirect();
+            readSlot = writeSlot;
+        }
+        simTime += frameTime;
+
+        // ---------------------------------------------------------
+        // 5. PRESENT
+        // ---------------------------------------------------------
+        // The newest state is drawn next frame
+        particleStore.ring.present(readSlot);
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
     {// Cleanup
+    if (reloader) reloader->stop();
+    trajectoryCapture.reset(); // Appends the copies still in flight
+    trajectoryWriter.close();
+    fieldTiles.reset();
+    diagnostics.reset();
+    mortonSorter.reset();
+    gpuPrimitives.reset();
     glDeleteVertexArrays(1, &VAO);
     glDeleteVertexArrays(1, &bgVAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &bgVBO);
-    glDeleteBuffers(2, particlesSSBO);
+    particleStore.destroy();
+    speciesTable.destroy();
+    obstacles.destroy();
     glDeleteBuffers(1, &fieldSSBO);
     }
 
@@ -300,20 +622,17 @@ void initGeometry() {
     glEnableVertexAttribArray(0);
 }
 
-void initSSBOs() {
-    // 1. Particles (Double Buffered)
-    glGenBuffers(2, particlesSSBO);
-    std::vector<Particle> initialBuffer(MAX_PARTICLES);
-    // Copy existing particles into the zeroed buffer
-    if(!particles.empty()) {
-        std::copy(particles.begin(), particles.end(), initialBuffer.begin());
-    }
+void initSSBOs(bool sortParticles, uint32_t minimumCount) {
+    // 1. Particles (Triple Buffered Ring)
+    uint32_t count = static_cast<uint32_t>(initialParticles.size());
+    uint32_t needed = std::max(count, minimumCount);
+    particleStore.init(needed > MAX_PARTICLES ? needed + LOAD_HEADROOM : MAX_PARTICLES);
 
-    for (int i = 0; i < 2; i++) {
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, particlesSSBO[i]);
-        // Allocate full MAX_PARTICLES size on GPU
-        glBufferData(GL_SHADER_STORAGE_BUFFER, MAX_PARTICLES * sizeof(Particle), initialBuffer.data(), GL_DYNAMIC_DRAW);
-    }
+    // The staged scene starts out spatially coherent (same order the GPU
+    // re-sort produces). From here on the GPU holds the only copy.
+    if (sortParticles) mortonSortCPU(initialParticles, glm::vec2(SCR_WIDTH, SCR_HEIGHT));
+    particleStore.upload(0, initialParticles.data(), count);
+    std::vector<Particle>().swap(initialParticles);
 
     // 2. Field (Single Buffered)
     glGenBuffers(1, &fieldSSBO);
@@ -325,28 +644,72 @@ void initSSBOs() {
 }
 
 glm::vec4 randomColour() {
-    return glm::vec4((rand() % 100) / 100.0f, (rand() % 100) / 100.0f, (rand() % 100) / 100.0f, 1.0f);
+    return glm::vec4(rng.nextFloat(), rng.nextFloat(), rng.nextFloat(), 1.0f);
 }
 
 glm::vec4 randomDirection2D(){
-    float angle = static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.0f * 3.14159265f;
+    float angle = rng.nextFloat() * 2.0f * 3.14159265f;
     return glm::vec4(cos(angle), sin(angle), 0.0f, 0.0f);
 }
 
-void circle(float x, float y, float radius) {
-    if (particles.size() >= MAX_PARTICLES) return;
+void initSpecies() {
+    // 0: the original light blue particles
+    SpeciesParams light;
+    speciesTable.species.push_back(light);
+
+    // 1: heavier, larger and less bouncy (right click)
+    SpeciesParams heavy;
+    heavy.mass = 4.0f;
+    heavy.radius = 14.0f;
+    heavy.restitution = 0.6f;
+    heavy.color = glm::vec4(1.0f, 0.55f, 0.2f, 1.0f); // Orange
+    speciesTable.species.push_back(heavy);
+
+    // Unlike species push each other apart less than like ones
+    speciesTable.interaction[0][1] = 0.5f;
+    speciesTable.interaction[1][0] = 0.5f;
+}
+
+bool initObstacles(int argc, char** argv) {
+    // --obstacles mask.png: bright pixels are solid, stretched over the window
+    if (const char* mask = argValue(argc, argv, "--obstacles")) {
+        if (!obstacles.loadMask(mask)) return false;
+    } else if (DEFAULT_OBSTACLES) {
+        obstacles.shapes.push_back(ObstacleShape::circle(glm::vec2(-320.0f, -200.0f), 50.0f));
+        obstacles.shapes.push_back(ObstacleShape::box(glm::vec2(320.0f, 180.0f), glm::vec2(40.0f, 80.0f)));
+    }
+    if (obstacles.empty()) return true;
+
+    // Same grid as the field; fixed at startup like it. Uploaded once GL is up.
+    obstacles.bakeDistances(SCR_WIDTH, SCR_HEIGHT);
+    return true;
+}
+
+Particle makeParticle(float x, float y, int species) {
+    const SpeciesParams& params = speciesTable[species];
     
     Particle newparticle;
-    newparticle.pos_radius = glm::vec4(x, y, 1.0f, radius);
+    newparticle.pos_radius = glm::vec4(x, y, 1.0f, params.radius);
     newparticle.velocity = randomDirection2D() * 0.0f; 
-    newparticle.color = glm::vec4(0.2f, 0.6f, 1.0f, 1.0f); // Light blue
+    newparticle.velocity.w = (float)species; // Species id rides in the unused w
+    newparticle.color = params.color;
     
-    particles.push_back(newparticle);
-    resendData = true; 
+    return newparticle;
+}
+
+// Queued in the store and emitted on the GPU at the start of the next frame
+void circle(float x, float y, int species) {
+    if (particleStore.count() >= particleStore.capacity()) return; // Full: don't draw from the RNG either
+    particleStore.append(makeParticle(x, y, species));
 }
 
 void processInput(GLFWwindow* window) {
     static bool mousePressed = false;
+    static bool rightMousePressed = false;
+    static bool pushKeyPressed = false;
+    static bool collisionKeyPressed = false;
+    static bool boundaryKeyPressed = false;
+    static bool checkpointKeyPressed = false;
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
     if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
@@ -354,18 +717,47 @@ void processInput(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
         GRAVITY_CONSTANT = glm::clamp(GRAVITY_CONSTANT - 10.0f * deltaTime, 0.5f, 500.0f);
 
+    bool pushKey = glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS;
+    if (pushKey && !pushKeyPressed) pushEnabled = !pushEnabled;
+    pushKeyPressed = pushKey;
+
+    bool collisionKey = glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS;
+    if (collisionKey && !collisionKeyPressed) collisionsEnabled = !collisionsEnabled;
+    collisionKeyPressed = collisionKey;
+
+    bool boundaryKey = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+    if (boundaryKey && !boundaryKeyPressed) periodicBoundary = !periodicBoundary;
+    boundaryKeyPressed = boundaryKey;
+
+    bool checkpointKey = glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS;
+    if (checkpointKey && !checkpointKeyPressed) checkpointRequested = true;
+    checkpointKeyPressed = checkpointKey;
+
     if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
         if (!mousePressed) {
             double xpos, ypos;
             glfwGetCursorPos(window, &xpos, &ypos);
             float centerX = (float)xpos - (SCR_WIDTH / 2.0f);
             float centerY = (SCR_HEIGHT / 2.0f) - (float)ypos; 
-            circle(centerX, centerY, 10.0f);
+            circle(centerX, centerY, 0);
             mousePressed = true;
         }
     } else {
         mousePressed = false;
     }
+
+    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) {
+        if (!rightMousePressed) {
+            double xpos, ypos;
+            glfwGetCursorPos(window, &xpos, &ypos);
+            float centerX = (float)xpos - (SCR_WIDTH / 2.0f);
+            float centerY = (SCR_HEIGHT / 2.0f) - (float)ypos;
+            circle(centerX, centerY, 1);
+            rightMousePressed = true;
+        }
+    } else {
+        rightMousePressed = false;
+    }
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
@@ -376,43 +768,43 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     // and re-allocate the fieldSSBO, otherwise the grid logic will break.
 }
 
-void dumpParticlesToFile(GLuint particlesSSBO, size_t particleCount, const std::string& filename) {
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, particlesSSBO);
-    Particle* gpuParticles = static_cast<Particle*>(
-        glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_ONLY)
-    );
-
-    if (!gpuParticles) {
-        std::cerr << "ERROR: Failed to map particle SSBO\n";
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-        return;
-    }
-
+void dumpParticlesToFile(const Particle* gpuParticles, size_t particleCount, const std::string& filename) {
     std::ofstream out(filename);
     if (!out.is_open()) {
-        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        std::cerr << "ERROR: Failed to open " << filename << "\n";
         return;
     }
 
-    out << std::fixed << std::setprecision(4);
-    out << "index,x,y,z,r,vx,vy,vz,vw,cr,cg,cb,ca\n";
-
-    for (size_t i = 0; i < particleCount; ++i) {
-        const Particle& p = gpuParticles[i];
-        out << i << ","
-            << p.pos_radius.x << "," << p.pos_radius.y << "," << p.pos_radius.z << "," << p.pos_radius.w << ","
-            << p.velocity.x   << "," << p.velocity.y   << "," << p.velocity.z   << "," << p.velocity.w   << ","
-            << p.color.r      << "," << p.color.g      << "," << p.color.b      << "," << p.color.a
-            << "\n";
-    }
+    importer::writeCsv(out, gpuParticles, particleCount);
 
     out.close();
-    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
     std::cout << "Saved " << particleCount << " particles to " << filename << "\n";
 }
 
+// CSV by default; with --compress-snapshots, the snapshot codec on 'pool' (or
+// a pool made for the occasion)
+void dumpParticles(const Particle* gpuParticles, size_t particleCount, WorkStealingPool* pool) {
+    if (!compressSnapshots) {
+        dumpParticlesToFile(gpuParticles, particleCount, "particle_dump.csv");
+        return;
+    }
+    std::unique_ptr<WorkStealingPool> ownPool;
+    if (!pool) {
+        ownPool = std::make_unique<WorkStealingPool>();
+        pool = ownPool.get();
+    }
+    const char* filename = "particle_dump.snap";
+    auto start = std::chrono::steady_clock::now();
+    if (!snapshot::save(filename, gpuParticles, static_cast<uint32_t>(particleCount), snapshotOptions, *pool)) return;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::error_code ec;
+    uintmax_t bytes = std::max<uintmax_t>(std::filesystem::file_size(filename, ec), 1);
+    std::cout << "Saved " << particleCount << " particles to " << filename << " (" << bytes << " bytes, "
+              << std::fixed << std::setprecision(1) << double(particleCount * sizeof(Particle)) / bytes
+              << "x smaller, " << seconds * 1000.0 << " ms)" << std::defaultfloat << "\n";
+}
+
 void initParticles() {
     //place particles in grid format
 
@@ -421,11 +813,431 @@ void initParticles() {
     float spacing = 20.0f; // Space between particles
     for(int i = 0; i < particlesPerCol; i++) {
         for(int j = 0; j < particlesPerRow; j++) {
-            if(particles.size() >= INITIAL_PARTICLES) break;
+            if(initialParticles.size() >= INITIAL_PARTICLES) break;
             float x = (j - particlesPerRow / 2) * spacing;
             float y = (i - particlesPerCol / 2) * spacing;
-            circle(x, y, 10.0f);
+            initialParticles.push_back(makeParticle(x, y, 0));
+        }
+    }
+}
+
+ComputeShader::Defines physicsDefines() {
+    return {
+        {"WORKGROUP_SIZE", std::to_string(physicsWorkgroupSize)},
+        {"ENABLE_PUSH", pushEnabled ? "1" : "0"},
+        {"ENABLE_COLLISIONS", collisionsEnabled ? "1" : "0"},
+        {"NUM_SPECIES", std::to_string(speciesTable.count())},
+        {"ENABLE_SDF", obstacles.empty() ? "0" : "1"},
+        {"PERIODIC_BOUNDARY", periodicBoundary ? "1" : "0"},
+    };
+}
+
+void autotuneComputePasses(ComputeShader& gravityShader, ComputeShader& physicsShader, bool force, bool verbose) {
+    // Particle counts spanning a light scene to a full buffer
+    std::vector<unsigned int> counts = { INITIAL_PARTICLES, MAX_PARTICLES / 4, MAX_PARTICLES };
+    particleStore.counter.bind();
+
+    // With SPARSE_FIELD the field runs gravityTilesShader, whose workgroup is
+    // one tile; the dense kernel never runs, so it keeps its default size
+    unsigned int stored = SPARSE_FIELD ? gravityWorkgroupSize : force ? 0 : Autotuner::lookup("gravity");
+    if (stored) {
+        gravityShader.setDefine("WORKGROUP_SIZE", std::to_string(stored));
+    } else {
+        stored = Autotuner::tune("gravity", gravityShader, counts, [](ComputeShader& s, unsigned int n) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleStore.ring.presentedBuffer());
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, fieldSSBO);
+            s.setVec2("dimensions", (float)SCR_WIDTH, (float)SCR_HEIGHT);
+            particleStore.counter.setCount(n);
+            s.setFloat("gravityConstant", GRAVITY_CONSTANT);
+            s.setInt("numFields", (int)fields.size());
+            s.dispatch1D((unsigned int)fields.size());
+        }, verbose);
+    }
+    gravityWorkgroupSize = stored;
+
+    stored = force ? 0 : Autotuner::lookup("physics");
+    if (stored) {
+        physicsWorkgroupSize = stored;
+        physicsShader.setDefines(physicsDefines());
+    } else {
+        // Writes only into a slot that is not presented, so the scene is untouched
+        int writeSlot = particleStore.ring.acquire(particleStore.ring.presented());
+        stored = Autotuner::tune("physics", physicsShader, counts, [writeSlot](ComputeShader& s, unsigned int n) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleStore.ring.presentedBuffer());
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, particleStore.ring.buffer(writeSlot));
+            particleStore.counter.setCount(n);
+            s.setFloat("gravity", GRAVITY);
+            s.setVec2("dimensions", (float)SCR_WIDTH, (float)SCR_HEIGHT);
+            s.setFloat("deltaTime", 0.004f);
+            s.setVec2("sdfWorldSize", obstacles.worldSize);
+            s.dispatch1D(n);
+        }, verbose);
+    }
+    physicsWorkgroupSize = stored;
+
+    particleStore.counter.setCount(particleStore.count());
+}
+
+bool hasArg(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == name) return true;
+    }
+    return false;
+}
+
+// Value following 'name' on the command line, or nullptr
+const char* argValue(int argc, char** argv, const char* name) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == name) return argv[i + 1];
+    }
+    return nullptr;
+}
+
+// --headless [--steps N] [--threads N] [--isa scalar|sse2|avx2]: runs the CPU
+// mirror of physics.comp and gravity.comp for N frames of 4 substeps at a fixed
+// 60 Hz and writes the dump. With --deterministic the printed state hash is the
+// same for any thread count and ISA. --steps counts from the start of the run,
+// so a resumed job stops where the uninterrupted one would have.
+int runHeadless(int argc, char** argv, const Checkpoint* resumed) {
+    int steps = HEADLESS_STEPS;
+    if (const char* value = argValue(argc, argv, "--steps")) steps = std::max(1, std::atoi(value));
+    unsigned int threads = std::thread::hardware_concurrency();
+    if (const char* value = argValue(argc, argv, "--threads")) threads = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+
+    if (!resumed && initialParticles.empty()) initParticles();
+    fields.resize(SCR_WIDTH * SCR_HEIGHT, glm::vec2(0.0f));
+
+    WorkStealingPool pool(threads);
+    CpuPhysics cpuPhysics(speciesTable, &obstacles, &pool);
+    if (const char* isa = argValue(argc, argv, "--isa")) {
+        std::string name = isa;
+        CpuPhysics::Isa requested = cpuPhysics.isa();
+        if (name == "scalar") requested = CpuPhysics::Isa::Scalar;
+        else if (name == "sse2") requested = CpuPhysics::Isa::SSE2;
+        else if (name == "avx2") requested = CpuPhysics::Isa::AVX2;
+        else std::cerr << "WARNING: unknown --isa " << name << ", keeping " << cpu_kernels::isaName(requested) << "\n";
+        if (!cpuPhysics.setIsa(requested)) {
+            std::cerr << "WARNING: --isa " << name << " is not supported here, using " << cpu_kernels::isaName(cpuPhysics.isa()) << "\n";
+        }
+    }
+    cpuPhysics.setDeterministic(deterministic);
+    cpuPhysics.load(initialParticles);
+
+    CpuPhysicsParams params;
+    params.gravity = GRAVITY;
+    params.dimensions = glm::vec2(SCR_WIDTH, SCR_HEIGHT);
+    params.push = pushEnabled;
+    params.collisions = collisionsEnabled;
+    params.periodic = periodicBoundary;
+
+    const int numSubsteps = 4;
+    const float frameTime = FIXED_TIMESTEP;
+    std::cout << "Headless: " << initialParticles.size() << " particles, " << steps << " frames, "
+              << cpu_kernels::isaName(cpuPhysics.isa()) << " kernels, " << pool.size() << " threads"
+              << (deterministic ? ", deterministic" : "") << "\n";
+
+    using Clock = std::chrono::steady_clock;
+    double physicsSeconds = 0.0;
+    double fieldSeconds = 0.0;
+    std::vector<Particle> recorded;
+    int firstFrame = resumed ? static_cast<int>(resumed->frame) : 0;
+    int frame = firstFrame;
+    for (; frame < steps; frame++) {
+        // Same frame boundary as the render loop: 'frame' frames are complete
+        bool intervalDue = checkpointInterval > 0 && frame % checkpointInterval == 0 && frame != firstFrame;
+        if (intervalDue || terminateRequested) {
+            Checkpoint checkpoint = hostCheckpoint(frame);
+            cpuPhysics.store(checkpoint.particles);
+            if (checkpoint.save(checkpointPath)) std::cout << "Checkpoint: frame " << frame << " -> " << checkpointPath << "\n";
+            if (terminateRequested) break;
+        }
+        if (trajectoryWriter.isOpen() && frame % recordInterval == 0) {
+            cpuPhysics.store(recorded);
+            trajectoryWriter.append(recorded.data(), static_cast<uint32_t>(recorded.size()), simTime);
+        }
+
+        auto start = Clock::now();
+        for (int i = 0; i < numSubsteps; i++) cpuPhysics.step(frameTime / numSubsteps, params);
+        auto physicsDone = Clock::now();
+        cpuPhysics.computeField(GRAVITY_CONSTANT, params, fields);
+        physicsSeconds += std::chrono::duration<double>(physicsDone - start).count();
+        fieldSeconds += std::chrono::duration<double>(Clock::now() - physicsDone).count();
+        simTime += frameTime;
+    }
+    if (trajectoryWriter.isOpen() && frame % recordInterval == 0) {
+        cpuPhysics.store(recorded);
+        trajectoryWriter.append(recorded.data(), static_cast<uint32_t>(recorded.size()), simTime);
+    }
+    if (trajectoryWriter.isOpen()) {
+        std::cout << "Headless: recorded " << trajectoryWriter.frames() << " frames, " << trajectoryWriter.bytes() << " bytes\n";
+        trajectoryWriter.close();
+    }
+
+    int simulated = std::max(1, frame - firstFrame);
+    std::cout << std::fixed << std::setprecision(3) << "Headless: " << simulated / (physicsSeconds + fieldSeconds)
+              << " frames/s | physics " << physicsSeconds * 1000.0 / simulated << " ms/frame"
+              << " | field " << fieldSeconds * 1000.0 / simulated << " ms/frame\n";
+
+    cpuPhysics.store(initialParticles);
+    std::cout << "Headless: state hash " << std::hex << std::setw(16) << std::setfill('0')
+              << stateHash(initialParticles) << std::dec << std::setfill(' ') << "\n";
+    dumpParticles(initialParticles.data(), initialParticles.size(), &pool);
+    return 0;
+}
+
+// Replaces 'initialParticles' with the scene in 'path' (see particleImporter.h).
+// Species ids the species table does not have are mapped to species 0.
+bool loadParticles(const char* path) {
+    auto start = std::chrono::steady_clock::now();
+    WorkStealingPool pool;
+    std::vector<Particle> loaded;
+    if (!importer::load(path, loaded, pool)) return false;
+
+    size_t remapped = 0;
+    float species = static_cast<float>(speciesTable.count());
+    for (Particle& p : loaded) {
+        if (!(p.velocity.w >= 0.0f && p.velocity.w < species) || p.velocity.w != std::floor(p.velocity.w)) {
+            p.velocity.w = 0.0f;
+            remapped++;
         }
     }
+    initialParticles.swap(loaded);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Loaded " << initialParticles.size() << " particles from " << path << " in " << std::fixed << std::setprecision(1)
+              << seconds * 1000.0 << " ms" << std::defaultfloat << "\n";
+    if (remapped > 0) std::cout << "Loaded: " << remapped << " particles had an unknown species and use species 0\n";
+    return true;
 }
 
+// --scene grid|disc|random|poisson|dambreak. Count defaults to the built-in
+// grid's, spacing to what keeps the scene's particles just apart; poisson
+// fills the window at --scene-spacing and ignores the count.
+bool parseScene(int argc, char** argv, SceneSpec& spec) {
+    const char* name = argValue(argc, argv, "--scene");
+    if (!SceneSpec::parse(name, spec.scene)) {
+        std::cerr << "Unknown --scene " << name << " (grid, disc, random, poisson or dambreak)\n";
+        return false;
+    }
+    spec.species = 0;
+    if (const char* value = argValue(argc, argv, "--scene-species")) spec.species = std::atoi(value);
+    if (spec.species < 0 || spec.species >= speciesTable.count()) {
+        std::cerr << "--scene-species must be below " << speciesTable.count() << "\n";
+        return false;
+    }
+    const SpeciesParams& params = speciesTable[spec.species];
+    spec.radius = params.radius;
+    spec.color = params.color;
+    spec.dimensions = glm::vec2(SCR_WIDTH, SCR_HEIGHT);
+    spec.seed = (static_cast<uint64_t>(rng.nextUint()) << 32) | rng.nextUint(); // Same scene for the same --seed
+
+    spec.count = INITIAL_PARTICLES;
+    if (const char* value = argValue(argc, argv, "--scene-count")) spec.count = static_cast<uint32_t>(std::max(1, std::atoi(value)));
+    switch (spec.scene) {
+        case Scene::Grid: spec.spacing = 20.0f; break; // As initParticles()
+        case Scene::PoissonDisc: spec.spacing = 3.0f * params.radius; break;
+        default: spec.spacing = 2.2f * params.radius; break;
+    }
+    if (const char* value = argValue(argc, argv, "--scene-spacing")) spec.spacing = static_cast<float>(std::atof(value));
+    if (!(spec.spacing > 0.0f)) {
+        std::cerr << "--scene-spacing must be positive\n";
+        return false;
+    }
+    return true;
+}
+
+// --record PATH [--record-every N] [--record-quantized]. A resumed run starts
+// a new file.
+bool openTrajectory(int argc, char** argv) {
+    const char* path = argValue(argc, argv, "--record");
+    if (!path) return true;
+    if (const char* value = argValue(argc, argv, "--record-every")) recordInterval = std::max(1, std::atoi(value));
+
+    trajectory::Options options;
+    options.keyframeInterval = TRAJECTORY_KEYFRAME_INTERVAL;
+    if (hasArg(argc, argv, "--record-quantized")) options.encoding = trajectory::Encoding::Quantized;
+    if (!trajectoryWriter.open(path, options)) return false;
+
+    std::cout << "Recording every " << recordInterval << " frame(s) to " << path
+              << (options.encoding == trajectory::Encoding::Quantized ? " (quantized)" : "") << "\n";
+    return true;
+}
+
+// --replay PATH [--speed X]: draws the recorded frames with the particle shader.
+// Space pauses, Left/Right seek a second (a frame while paused), Up/Down double
+// or halve the speed, R reverses and Home/End jump to either end. The field is
+// not recorded, so there is no background.
+int runReplay(const char* path, int argc, char** argv) {
+    initWindow();
+    glfwSetWindowTitle(window, "Replay");
+    initGeometry();
+
+    int status = 0;
+    {
+    GraphicsShader shader("shaders/vertex2D.vert", "shaders/fragment2D.frag");
+    ReplayPlayer player;
+    if (player.open(path)) {
+        if (const char* value = argValue(argc, argv, "--speed")) player.setSpeed(std::atof(value));
+        std::cout << "Replaying " << path << ": " << player.frames() << " frames, " << player.duration() << " s"
+                  << (player.persistentUpload() ? " (persistent-mapped upload)" : "") << "\n";
+
+        float statusTimer = 0.0f;
+        lastFrame = (float)glfwGetTime();
+        while (!glfwWindowShouldClose(window)) {
+            float currentFrame = (float)glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+
+            processReplayInput(window, player);
+            if (SCR_WIDTH == 0 || SCR_HEIGHT == 0) { glfwWaitEvents(); continue; }
+            player.update(deltaTime);
+
+            statusTimer += deltaTime;
+            if (statusTimer >= 0.25f) {
+                std::cout << std::fixed << std::setprecision(2) << "Replay: " << player.time() << " s | frame "
+                          << player.shownFrame() << "/" << player.frames() << " | speed " << player.speed()
+                          << (player.isPaused() ? " (paused)" : "") << "        \r";
+                std::cout.flush();
+                statusTimer = 0.0f;
+            }
+
+            glClear(GL_COLOR_BUFFER_BIT);
+            glm::mat4 projection = glm::ortho(-(float)SCR_WIDTH / 2.0f, (float)SCR_WIDTH / 2.0f, -(float)SCR_HEIGHT / 2.0f, (float)SCR_HEIGHT / 2.0f);
+            shader.use();
+            shader.setMat4("projection", projection);
+
+            // The frame's slot goes to binding 0, where vertex2D.vert reads it
+            uint32_t count = player.bind(0);
+            glBindVertexArray(VAO);
+            if (count > 0) glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+            player.drawn();
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        std::cout << "\n";
+    } else {
+        status = 1;
+    }
+    player.close();
+    }
+
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteVertexArrays(1, &bgVAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &bgVBO);
+    glfwTerminate();
+    return status;
+}
+
+void processReplayInput(GLFWwindow* window, ReplayPlayer& player) {
+    static bool held[GLFW_KEY_LAST + 1] = {};
+    auto pressedOnce = [&](int key) {
+        bool down = glfwGetKey(window, key) == GLFW_PRESS;
+        bool edge = down && !held[key];
+        held[key] = down;
+        return edge;
+    };
+
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (pressedOnce(GLFW_KEY_SPACE)) {
+        // Resuming at the end of the direction of play starts over
+        if (player.isPaused()) {
+            if (player.speed() >= 0.0 && player.time() >= player.end()) player.seek(player.start());
+            if (player.speed() < 0.0 && player.time() <= player.start()) player.seek(player.end());
+        }
+        player.setPaused(!player.isPaused());
+    }
+    if (pressedOnce(GLFW_KEY_RIGHT)) {
+        if (player.isPaused()) player.step(1);
+        else player.seek(player.time() + 1.0);
+    }
+    if (pressedOnce(GLFW_KEY_LEFT)) {
+        if (player.isPaused()) player.step(-1);
+        else player.seek(player.time() - 1.0);
+    }
+    if (pressedOnce(GLFW_KEY_UP)) player.setSpeed(glm::clamp(player.speed() * 2.0, -64.0, 64.0));
+    if (pressedOnce(GLFW_KEY_DOWN)) {
+        double slower = player.speed() * 0.5;
+        player.setSpeed(std::abs(slower) < 1.0 / 64.0 ? player.speed() : slower);
+    }
+    if (pressedOnce(GLFW_KEY_R)) player.setSpeed(-player.speed());
+    if (pressedOnce(GLFW_KEY_HOME)) player.seek(player.start());
+    if (pressedOnce(GLFW_KEY_END)) player.seek(player.end());
+}
+
+void onTerminate(int) {
+    terminateRequested = 1;
+}
+
+// Host half of a checkpoint; the caller fills in particles (and the field, if
+// it has a newer one than 'fields')
+Checkpoint hostCheckpoint(long long frame) {
+    Checkpoint checkpoint;
+    checkpoint.frame = static_cast<uint64_t>(frame);
+    checkpoint.simTime = simTime;
+    checkpoint.gravityConstant = GRAVITY_CONSTANT;
+    checkpoint.pushEnabled = pushEnabled;
+    checkpoint.collisionsEnabled = collisionsEnabled;
+    checkpoint.periodicBoundary = periodicBoundary;
+    checkpoint.deterministic = deterministic;
+    checkpoint.rngSeed = rng.seed();
+    checkpoint.rngStream = rng.streamId();
+    checkpoint.rngPosition = rng.position();
+    // The field is only kept if it still matches the window (it is sized once)
+    if (fields.size() == static_cast<size_t>(SCR_WIDTH) * SCR_HEIGHT) {
+        checkpoint.fieldWidth = static_cast<uint32_t>(SCR_WIDTH);
+        checkpoint.fieldHeight = static_cast<uint32_t>(SCR_HEIGHT);
+        checkpoint.fields = fields;
+    }
+    return checkpoint;
+}
+
+void restoreCheckpoint(const Checkpoint& checkpoint) {
+    initialParticles = checkpoint.particles;
+    simTime = checkpoint.simTime;
+    GRAVITY_CONSTANT = checkpoint.gravityConstant;
+    pushEnabled = checkpoint.pushEnabled;
+    collisionsEnabled = checkpoint.collisionsEnabled;
+    periodicBoundary = checkpoint.periodicBoundary;
+    deterministic = checkpoint.deterministic;
+    rng = PhiloxStream(checkpoint.rngSeed, checkpoint.rngStream);
+    rng.seek(checkpoint.rngPosition);
+    // A different window size just starts from an empty field; it is rebuilt every frame
+    if (checkpoint.fieldWidth == static_cast<uint32_t>(SCR_WIDTH) && checkpoint.fieldHeight == static_cast<uint32_t>(SCR_HEIGHT)) {
+        fields = checkpoint.fields;
+    }
+}
+
+// Blocking readback of the presented slot and the field. Checkpoints are rare,
+// and the GPU and host halves must come from the same frame boundary.
+void saveGpuCheckpoint(long long frame) {
+    Checkpoint checkpoint = hostCheckpoint(frame);
+
+    barriers.host("checkpoint", particleStore.ring.presentedBuffer());
+    particleStore.download(checkpoint.particles);
+
+    if (!checkpoint.fields.empty()) {
+        barriers.host("checkpoint", fieldSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, fieldSSBO);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, checkpoint.fields.size() * sizeof(glm::vec2), checkpoint.fields.data());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    if (checkpoint.save(checkpointPath)) {
+        std::cout << "\nCheckpoint: frame " << frame << ", " << checkpoint.particles.size() << " particles -> " << checkpointPath << "\n";
+    }
+}
+
+// FNV-1a over the raw particle bytes: equal hashes mean bit-identical state
+uint64_t stateHash(const std::vector<Particle>& state) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(state.data());
+    for (size_t i = 0; i < state.size() * sizeof(Particle); i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
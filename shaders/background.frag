@@ -16,6 +16,10 @@ layout(std430, binding = 3) buffer Screen {
 uniform float fieldScale;       
 uniform vec2 dimensions;       
 
+// Static obstacles (see obstacles.h)
+layout(binding = 0) uniform sampler2D obstacleSDF;
+uniform int showObstacles;
+
 // --------------------------------------------------------
 // Heatmap Color Function
 // --------------------------------------------------------
@@ -56,7 +60,16 @@ void main()
     float logStrength = log(1.0 + fieldStrength * fieldScale) / log(2.0);
     vec3 fieldColor = heatmap(logStrength);
 
-    // 4. Final Output
+    // 4. Obstacles: solid grey with a soft outline
+    if (showObstacles != 0) {
+        float d = texture(obstacleSDF, (vec2(x, y) + 0.5) / dimensions).r;
+        float solid = 1.0 - smoothstep(-1.0, 1.0, d);
+        float outline = 1.0 - smoothstep(0.0, 3.0, abs(d));
+        fieldColor = mix(fieldColor, vec3(0.35), solid * 0.85);
+        fieldColor = mix(fieldColor, vec3(0.9), outline * 0.6);
+    }
+
+    // 5. Final Output
     // No particle loop. Just the field.
     FragColor = vec4(fieldColor, 1.0);
 }
\ No newline at end of file
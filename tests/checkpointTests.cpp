@@ -0,0 +1,87 @@
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "checkpoint.h"
+#include "testing.h"
+
+namespace {
+
+Checkpoint sample() {
+    Checkpoint c;
+    c.frame = 1234;
+    c.simTime = 10.25;
+    c.gravityConstant = 3.5f;
+    c.collisionsEnabled = false;
+    c.periodicBoundary = true;
+    c.deterministic = true;
+    c.rngSeed = 0x0123456789abcdefull;
+    c.rngStream = 3;
+    c.rngPosition = 77;
+    c.particles = testing::randomParticles(500, 11);
+    c.fieldWidth = 4;
+    c.fieldHeight = 3;
+    for (uint32_t i = 0; i < c.fieldWidth * c.fieldHeight; i++) c.fields.emplace_back(i * 0.5f, -1.0f * i);
+    return c;
+}
+
+std::vector<char> readFile(const testing::TempFile& file) {
+    std::ifstream in(file.path, std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const testing::TempFile& file, const std::vector<char>& bytes) {
+    std::ofstream out(file.path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+} // namespace
+
+TEST(checkpointRoundTrip) {
+    testing::TempFile file("checkpoint.bin");
+    Checkpoint saved = sample();
+    CHECK(saved.save(file.string()));
+
+    Checkpoint loaded;
+    CHECK(loaded.load(file.string()));
+    CHECK(loaded.frame == saved.frame);
+    CHECK(loaded.simTime == saved.simTime);
+    CHECK(loaded.gravityConstant == saved.gravityConstant);
+    CHECK(loaded.pushEnabled == saved.pushEnabled);
+    CHECK(loaded.collisionsEnabled == saved.collisionsEnabled);
+    CHECK(loaded.periodicBoundary == saved.periodicBoundary);
+    CHECK(loaded.deterministic == saved.deterministic);
+    CHECK(loaded.rngSeed == saved.rngSeed);
+    CHECK(loaded.rngStream == saved.rngStream);
+    CHECK(loaded.rngPosition == saved.rngPosition);
+    CHECK(loaded.particles.size() == saved.particles.size());
+    CHECK(std::memcmp(loaded.particles.data(), saved.particles.data(), saved.particles.size() * sizeof(Particle)) == 0);
+    CHECK(loaded.fieldWidth == saved.fieldWidth);
+    CHECK(loaded.fieldHeight == saved.fieldHeight);
+    CHECK(loaded.fields == saved.fields);
+}
+
+TEST(checkpointRejectsDamage) {
+    testing::TempFile file("checkpoint_damaged.bin");
+    CHECK(sample().save(file.string()));
+    const std::vector<char> original = readFile(file);
+
+    // One flipped byte in the header, the particles, the field and the CRC
+    for (size_t offset : { size_t(20), size_t(200), original.size() - 40, original.size() - 1 }) {
+        std::vector<char> damaged = original;
+        damaged[offset] ^= 0x10;
+        writeFile(file, damaged);
+        Checkpoint loaded;
+        CHECK(!loaded.load(file.string()));
+    }
+
+    std::vector<char> truncated(original.begin(), original.end() - 7);
+    writeFile(file, truncated);
+    Checkpoint loaded;
+    CHECK(!loaded.load(file.string()));
+
+    // The undamaged bytes still load
+    writeFile(file, original);
+    CHECK(loaded.load(file.string()));
+}
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "rans.h"
+#include "snapshotCodec.h"
+#include "testing.h"
+
+namespace {
+
+bool ransRoundTrips(const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> coded;
+    rans::encode(data.data(), data.size(), coded);
+    std::vector<uint8_t> decoded(data.size());
+    return rans::decode(coded.data(), coded.data() + coded.size(), decoded.data(), decoded.size()) && decoded == data;
+}
+
+using Key = std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, snapshot::Attributes>;
+
+// Quantized state of each particle under the snapshot's own quantizers, so
+// originals and decoded particles can be matched up despite the Morton order
+std::vector<Key> keys(const std::vector<Particle>& particles, const std::vector<uint8_t>& bytes) {
+    snapshot::Header h;
+    std::memcpy(&h, bytes.data(), sizeof(h));
+    snapshot::Quantizer qx(h.positionMin[0], h.positionMax[0], h.positionBits), qy(h.positionMin[1], h.positionMax[1], h.positionBits);
+    snapshot::Quantizer qvx(h.velocityMin[0], h.velocityMax[0], h.velocityBits), qvy(h.velocityMin[1], h.velocityMax[1], h.velocityBits);
+    std::vector<Key> out;
+    for (const Particle& p : particles) {
+        out.emplace_back(qx(p.pos_radius.x), qy(p.pos_radius.y), qvx(p.velocity.x), qvy(p.velocity.y), snapshot::attributesOf(p));
+    }
+    return out;
+}
+
+// Indices of 'particles' sorted by key
+std::vector<uint32_t> order(const std::vector<Particle>& particles, const std::vector<uint8_t>& bytes) {
+    std::vector<Key> k = keys(particles, bytes);
+    std::vector<uint32_t> indices(particles.size());
+    for (uint32_t i = 0; i < indices.size(); i++) indices[i] = i;
+    std::sort(indices.begin(), indices.end(), [&](uint32_t a, uint32_t b) { return k[a] < k[b]; });
+    return indices;
+}
+
+} // namespace
+
+TEST(ransRoundTrip) {
+    std::mt19937 rng(3);
+    CHECK(ransRoundTrips({}));
+    CHECK(ransRoundTrips({ 42 }));
+    CHECK(ransRoundTrips(std::vector<uint8_t>(5000, 7)));
+
+    std::vector<uint8_t> every(256 * 4);
+    for (size_t i = 0; i < every.size(); i++) every[i] = static_cast<uint8_t>(i);
+    CHECK(ransRoundTrips(every));
+
+    // Skewed alphabets of every size, mostly zeros like the delta streams
+    for (int trial = 0; trial < 100; trial++) {
+        std::vector<uint8_t> data(rng() % 5000);
+        uint32_t symbols = 1 + rng() % 256;
+        for (uint8_t& v : data) v = static_cast<uint8_t>(rng() % 3 ? rng() % symbols : 0);
+        CHECK(ransRoundTrips(data));
+    }
+
+    uint8_t out[4];
+    uint8_t tooShort[1] = { 0 };
+    CHECK(!rans::decode(tooShort, tooShort + 1, out, sizeof(out)));
+}
+
+TEST(snapshotRoundTrip) {
+    WorkStealingPool pool(3);
+    std::vector<Particle> particles = testing::randomParticles(5000, 9);
+    // Some per-particle colours, so the palette is not just the two species
+    std::mt19937 rng(4);
+    for (size_t i = 0; i < particles.size(); i += 7) particles[i].color.g = static_cast<float>(rng() % 1000) / 1000.0f;
+
+    snapshot::Options options;
+    options.chunkParticles = 1200; // Several chunks, the last one short
+    std::vector<uint8_t> bytes = snapshot::encode(particles.data(), static_cast<uint32_t>(particles.size()), options, pool);
+    CHECK(bytes.size() < particles.size() * sizeof(Particle));
+
+    std::vector<Particle> decoded;
+    CHECK(snapshot::decode(bytes.data(), bytes.size(), decoded, pool));
+    CHECK(decoded.size() == particles.size());
+    if (decoded.size() != particles.size()) return;
+
+    // Same particles once quantized, attributes included
+    std::vector<Key> expected = keys(particles, bytes), actual = keys(decoded, bytes);
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    CHECK(actual == expected);
+
+    // And no position is further than half a step from the original
+    snapshot::Header h;
+    std::memcpy(&h, bytes.data(), sizeof(h));
+    float halfStep[2];
+    for (int axis = 0; axis < 2; axis++) {
+        halfStep[axis] = (h.positionMax[axis] - h.positionMin[axis]) / ((1u << h.positionBits) - 1u) * 0.5f;
+    }
+    std::vector<uint32_t> originalOrder = order(particles, bytes), decodedOrder = order(decoded, bytes);
+    float worst = 0.0f;
+    for (size_t i = 0; i < particles.size(); i++) {
+        const Particle& a = particles[originalOrder[i]];
+        const Particle& b = decoded[decodedOrder[i]];
+        for (int axis = 0; axis < 2; axis++) {
+            worst = std::max(worst, std::fabs(a.pos_radius[axis] - b.pos_radius[axis]) / halfStep[axis]);
+        }
+    }
+    CHECK(worst <= 1.001f);
+}
+
+TEST(snapshotRejectsDamage) {
+    WorkStealingPool pool(2);
+    std::vector<Particle> particles = testing::randomParticles(3000, 10);
+    snapshot::Options options;
+    options.chunkParticles = 1000;
+    const std::vector<uint8_t> bytes = snapshot::encode(particles.data(), static_cast<uint32_t>(particles.size()), options, pool);
+
+    std::vector<Particle> decoded;
+    for (size_t offset : { size_t(20), sizeof(snapshot::Header) + 12, bytes.size() / 2, bytes.size() - 1 }) {
+        std::vector<uint8_t> damaged = bytes;
+        damaged[offset] ^= 0x55;
+        CHECK(!snapshot::decode(damaged.data(), damaged.size(), decoded, pool));
+    }
+    CHECK(!snapshot::decode(bytes.data(), bytes.size() - 1, decoded, pool));
+    CHECK(!snapshot::decode(bytes.data(), 10, decoded, pool));
+}
+
+TEST(snapshotEmpty) {
+    WorkStealingPool pool(1);
+    std::vector<uint8_t> bytes = snapshot::encode(nullptr, 0, snapshot::Options{}, pool);
+    std::vector<Particle> decoded(3);
+    CHECK(snapshot::decode(bytes.data(), bytes.size(), decoded, pool));
+    CHECK(decoded.empty());
+}
+
+TEST(snapshotChunkVarintsStayInTheirStream) {
+    // A consistent chunk whose position stream is one endless varint: it must
+    // fail, not read past the stream
+    const uint32_t count = 64;
+    snapshot::StreamHeader headers[snapshot::STREAMS];
+    uint32_t sizes[snapshot::STREAMS] = { 2 * count, 2 * count, count, sizeof(snapshot::Attributes) };
+    std::vector<uint8_t> chunk(sizeof(headers));
+    for (int s = 0; s < snapshot::STREAMS; s++) {
+        headers[s] = { sizes[s], sizes[s], snapshot::Method::Stored };
+        chunk.insert(chunk.end(), sizes[s], s == snapshot::POSITION ? 0x80 : 0x00);
+    }
+    std::memcpy(chunk.data(), headers, sizeof(headers));
+    CHECK(snapshot::detail::plausibleChunk(chunk.data(), chunk.size(), count));
+
+    snapshot::Quantizer q[2] = { { 0.0f, 1.0f, 16 }, { 0.0f, 1.0f, 16 } };
+    std::vector<Particle> out(count);
+    CHECK(!snapshot::detail::decodeChunk(chunk.data(), chunk.size(), count, q, q, out.data()));
+}
+
+TEST(snapshotNonFiniteValues) {
+    WorkStealingPool pool(1);
+    std::vector<Particle> particles = testing::randomParticles(100, 14);
+    particles[3].pos_radius.x = NAN;
+    particles[7].velocity.y = INFINITY;
+    particles[9].pos_radius.y = -INFINITY;
+    std::vector<uint8_t> bytes = snapshot::encode(particles.data(), static_cast<uint32_t>(particles.size()), snapshot::Options{}, pool);
+
+    // Bounds come from the finite values, which still round trip
+    snapshot::Header h;
+    std::memcpy(&h, bytes.data(), sizeof(h));
+    CHECK(std::isfinite(h.positionMin[0]) && std::isfinite(h.positionMax[1]) && std::isfinite(h.velocityMax[1]));
+    std::vector<Particle> decoded;
+    CHECK(snapshot::decode(bytes.data(), bytes.size(), decoded, pool));
+    CHECK(decoded.size() == particles.size());
+    for (const Particle& p : decoded) CHECK(std::isfinite(p.pos_radius.x) && std::isfinite(p.velocity.y));
+}
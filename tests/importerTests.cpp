@@ -0,0 +1,130 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "particleImporter.h"
+#include "testing.h"
+
+namespace {
+
+// parseFloat over the whole of 'text'; false if it stops early
+bool parseAll(const std::string& text, float& value) {
+    const char* end = text.data() + text.size();
+    return importer::parseFloat(text.data(), end, value) == end;
+}
+
+float fixed4(float v) {
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.4f", v);
+    return std::strtof(text, nullptr);
+}
+
+} // namespace
+
+TEST(parseFloatMatchesStrtof) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dump(-5000.0f, 5000.0f);
+    std::uniform_real_distribution<double> exponent(-30.0, 30.0);
+    char text[64];
+    for (int i = 0; i < 20000; i++) {
+        // What the dump writes: exact
+        std::snprintf(text, sizeof(text), "%.4f", dump(rng));
+        float value = 0.0f;
+        CHECK(parseAll(text, value));
+        CHECK(value == std::strtof(text, nullptr));
+
+        // Anything else: within an ulp
+        float wide = static_cast<float>((rng() % 2 ? -1.0 : 1.0) * std::pow(10.0, exponent(rng)));
+        for (const char* format : { "%.9g", "%e", "%.3E" }) {
+            std::snprintf(text, sizeof(text), format, wide);
+            float expected = std::strtof(text, nullptr);
+            CHECK(parseAll(text, value));
+            CHECK(value == expected || value == std::nextafter(expected, INFINITY) || value == std::nextafter(expected, -INFINITY));
+        }
+    }
+}
+
+TEST(parseFloatEdgeCases) {
+    float value = 0.0f;
+    CHECK(parseAll("0", value) && value == 0.0f);
+    CHECK(parseAll("-0.0000", value) && value == 0.0f && std::signbit(value));
+    CHECK(parseAll("+.5", value) && value == 0.5f);
+    CHECK(parseAll("7.", value) && value == 7.0f);
+    CHECK(parseAll("1e5", value) && value == 1e5f);
+    CHECK(parseAll("2.5E-3", value) && value == 2.5e-3f);
+    CHECK(parseAll("12345678901234567890123", value) && value == 1.2345679e22f);
+    CHECK(parseAll("inf", value) && std::isinf(value) && value > 0.0f);
+    CHECK(parseAll("-inf", value) && std::isinf(value) && value < 0.0f);
+    CHECK(parseAll("nan", value) && std::isnan(value));
+
+    // No digits, no number
+    for (const char* text : { "", "-", ".", "e5", "x1", "+e" }) {
+        CHECK(importer::parseFloat(text, text + std::strlen(text), value) == nullptr);
+    }
+    // A number stops at the first character that is not part of it, and an
+    // exponent without digits is not part of it
+    const char* text = "3.25e,";
+    CHECK(importer::parseFloat(text, text + 6, value) == text + 4 && value == 3.25f);
+}
+
+TEST(parseCsvReadsWriteCsv) {
+    WorkStealingPool pool(3);
+    // Enough rows to span several of parseCsv's parallel ranges
+    std::vector<Particle> particles = testing::randomParticles(30000, 12);
+    std::ostringstream csv;
+    importer::writeCsv(csv, particles.data(), particles.size());
+    std::string text = csv.str();
+    CHECK(text.size() > (2u << 20));
+
+    std::vector<Particle> parsed;
+    std::string error;
+    CHECK(importer::parseCsv(text.data(), text.size(), parsed, pool, error));
+    CHECK(parsed.size() == particles.size());
+    if (parsed.size() != particles.size()) return;
+
+    bool same = true;
+    for (size_t i = 0; i < particles.size(); i++) {
+        for (int c = 0; c < 4; c++) {
+            same &= parsed[i].pos_radius[c] == fixed4(particles[i].pos_radius[c]);
+            same &= parsed[i].velocity[c] == fixed4(particles[i].velocity[c]);
+            same &= parsed[i].color[c] == fixed4(particles[i].color[c]);
+        }
+    }
+    CHECK(same);
+
+    // Without the header, with blank lines and CRLF endings
+    std::string bare = "0,1,2,3,4,5,6,7,8,9,10,11,12\r\n\r\n1,-1,-2,-3,-4,-5,-6,-7,-8,-9,-10,-11,-12\r\n";
+    CHECK(importer::parseCsv(bare.data(), bare.size(), parsed, pool, error));
+    CHECK(parsed.size() == 2 && parsed[1].color.a == -12.0f);
+}
+
+TEST(parseCsvReportsFirstBadLine) {
+    WorkStealingPool pool(3);
+    std::vector<Particle> particles = testing::randomParticles(30000, 13);
+    std::ostringstream csv;
+    importer::writeCsv(csv, particles.data(), particles.size());
+    std::string text = csv.str();
+
+    // Damage the records of particles 25000 and 17000 (lines 25002 and 17002,
+    // after the header), in different ranges
+    for (size_t index : { 25000, 17000 }) {
+        std::string record = "\n" + std::to_string(index) + ",";
+        size_t at = text.find(record);
+        CHECK(at != std::string::npos);
+        text.replace(at + record.size(), 1, "x");
+    }
+
+    std::vector<Particle> parsed;
+    std::string error;
+    CHECK(!importer::parseCsv(text.data(), text.size(), parsed, pool, error));
+    CHECK(error.find("line 17002 ") == 0);
+
+    std::string shortRecord = "0,1,2,3\n";
+    CHECK(!importer::parseCsv(shortRecord.data(), shortRecord.size(), parsed, pool, error));
+    CHECK(error.find("line 1 ") == 0);
+}
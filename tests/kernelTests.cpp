@@ -0,0 +1,128 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "cpuKernels.h"
+#include "testing.h"
+
+using namespace cpu_kernels;
+
+namespace {
+
+// Candidates scattered around a body at the origin, close enough that most of
+// them push and a good share overlap it
+struct Scene {
+    std::vector<float> x, y, vx, vy, radius, mass;
+    std::vector<int32_t> species;
+    Body body{};
+
+    Scene(uint32_t count, uint32_t seed, float spread) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(-spread, spread), velocity(-30.0f, 30.0f);
+        std::uniform_real_distribution<float> size(4.0f, 16.0f);
+        for (uint32_t i = 0; i < count; i++) {
+            x.push_back(position(rng));
+            y.push_back(position(rng));
+            vx.push_back(velocity(rng));
+            vy.push_back(velocity(rng));
+            radius.push_back(size(rng));
+            mass.push_back(radius.back() * radius.back());
+            species.push_back(static_cast<int32_t>(rng() % 4));
+        }
+        body = { 0.5f, -0.25f, velocity(rng), velocity(rng), 10.0f, 100.0f };
+    }
+
+    Neighbours neighbours() const {
+        return { x.data(), y.data(), vx.data(), vy.data(), radius.data(), mass.data(), species.data() };
+    }
+};
+
+const float PUSH_ROW[4] = { 1500.0f, -800.0f, 200.0f, 0.0f };
+const float RESTITUTION_ROW[4] = { 0.2f, 0.5f, 0.8f, 1.0f };
+
+Constants constants(bool periodic) {
+    // A small periodic domain, so minimum-image wrapping actually happens
+    return { 1.0f / 120.0f, 40.0f, 0.01f, 0.2f, periodic ? 60.0f : 1920.0f, periodic ? 60.0f : 1080.0f, periodic };
+}
+
+// Push and collide over [begin, end) with one kernel set
+Delta run(const KernelSet& set, const Scene& scene, uint32_t begin, uint32_t end, const Constants& c, bool exact) {
+    Delta delta;
+    delta.exact = exact;
+    Neighbours n = scene.neighbours();
+    set.push(n, begin, end, scene.body, PUSH_ROW, c, delta);
+    set.collide(n, begin, end, scene.body, RESTITUTION_ROW, c, delta);
+    delta.resolve();
+    return delta;
+}
+
+bool close(float a, float b) {
+    return std::fabs(a - b) <= 1e-4f * std::max(1.0f, std::max(std::fabs(a), std::fabs(b)));
+}
+
+// The SIMD sets this machine can run
+std::vector<KernelSet> simdSets() {
+    std::vector<KernelSet> sets;
+    Isa best = detectIsa();
+    if (best >= Isa::SSE2) sets.push_back(kernels(Isa::SSE2));
+    if (best >= Isa::AVX2) sets.push_back(kernels(Isa::AVX2));
+    return sets;
+}
+
+} // namespace
+
+TEST(simdKernelsMatchScalar) {
+    KernelSet scalar = kernels(Isa::Scalar);
+    for (const KernelSet& simd : simdSets()) {
+        for (bool periodic : { false, true }) {
+            Constants c = constants(periodic);
+            // Odd sizes and offsets leave a scalar tail and unaligned lanes
+            for (uint32_t count : { 1u, 7u, 37u, 203u }) {
+                Scene scene(count, count * 31u + periodic, 35.0f);
+                for (uint32_t begin : { 0u, 3u }) {
+                    if (begin > count) continue;
+                    Delta expected = run(scalar, scene, begin, count, c, false);
+                    Delta actual = run(simd, scene, begin, count, c, false);
+                    CHECK(close(actual.px, expected.px));
+                    CHECK(close(actual.py, expected.py));
+                    CHECK(close(actual.vx, expected.vx));
+                    CHECK(close(actual.vy, expected.vy));
+                }
+            }
+        }
+    }
+}
+
+TEST(exactKernelsAreBitIdentical) {
+    KernelSet scalar = kernels(Isa::Scalar);
+    for (const KernelSet& simd : simdSets()) {
+        for (bool periodic : { false, true }) {
+            Constants c = constants(periodic);
+            for (uint32_t count : { 5u, 64u, 257u }) {
+                Scene scene(count, count * 17u + periodic, 35.0f);
+                Delta expected = run(scalar, scene, 0, count, c, true);
+                Delta actual = run(simd, scene, 0, count, c, true);
+                for (int i = 0; i < 4; i++) CHECK(actual.fixed[i] == expected.fixed[i]);
+
+                // Splitting the range must not change the exact sum either
+                Delta split;
+                split.exact = true;
+                Neighbours n = scene.neighbours();
+                uint32_t middle = count / 3;
+                simd.push(n, middle, count, scene.body, PUSH_ROW, c, split);
+                simd.push(n, 0, middle, scene.body, PUSH_ROW, c, split);
+                simd.collide(n, middle, count, scene.body, RESTITUTION_ROW, c, split);
+                simd.collide(n, 0, middle, scene.body, RESTITUTION_ROW, c, split);
+                for (int i = 0; i < 4; i++) CHECK(split.fixed[i] == expected.fixed[i]);
+            }
+        }
+    }
+}
+
+TEST(kernelsSeeInteractions) {
+    // Guards the comparisons above against a scene where nothing interacts
+    Scene scene(203, 5, 35.0f);
+    Delta delta = run(kernels(Isa::Scalar), scene, 0, 203, constants(false), false);
+    CHECK(delta.px != 0.0f || delta.py != 0.0f);
+    CHECK(delta.vx != 0.0f || delta.vy != 0.0f);
+}
@@ -0,0 +1,41 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+#include "cpuPrimitives.h"
+#include "testing.h"
+
+TEST(exclusiveScan) {
+    std::vector<uint32_t> data = { 3, 0, 4, 1, 5 };
+    cpu::exclusiveScan(data);
+    CHECK((data == std::vector<uint32_t>{ 0, 3, 3, 7, 8 }));
+
+    std::vector<uint32_t> empty;
+    cpu::exclusiveScan(empty);
+    CHECK(empty.empty());
+}
+
+TEST(radixSortMatchesStableSort) {
+    std::mt19937 rng(7);
+    for (int keyBits : { 32, 16, 4 }) {
+        uint32_t mask = keyBits == 32 ? ~0u : (1u << keyBits) - 1u;
+        std::vector<uint32_t> keys(20000), values(keys.size());
+        // Few distinct keys, so stability is actually exercised
+        for (uint32_t& k : keys) k = (rng() % 500) * 2654435761u & mask;
+        std::iota(values.begin(), values.end(), 0u);
+
+        std::vector<uint32_t> expected(values);
+        std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+        std::vector<uint32_t> expectedKeys(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) expectedKeys[i] = keys[expected[i]];
+
+        cpu::radixSort(keys, values, keyBits);
+        CHECK(keys == expectedKeys);
+        CHECK(values == expected);
+    }
+}
+
+TEST(compact) {
+    CHECK((cpu::compact({ 0, 1, 1, 0, 7, 0 }) == std::vector<uint32_t>{ 1, 2, 4 }));
+    CHECK(cpu::compact({ 0, 0 }).empty());
+}
@@ -0,0 +1,21 @@
+#include <cstring>
+#include <iostream>
+
+#include "testing.h"
+
+// Runs every registered case, or those whose name contains argv[1]
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : "";
+    int run = 0, failed = 0;
+    for (const testing::Case& test : testing::cases()) {
+        if (!std::strstr(test.name, filter)) continue;
+        int before = testing::failures();
+        test.run();
+        bool ok = testing::failures() == before;
+        std::cout << (ok ? "ok      " : "FAILED  ") << test.name << "\n";
+        run++;
+        failed += ok ? 0 : 1;
+    }
+    std::cout << run - failed << "/" << run << " passed\n";
+    return failed == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#ifndef TESTING_H
+#define TESTING_H
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "particle.h"
+
+// Minimal registry for the CPU-only test executable. TEST(name) defines and
+// registers a case; CHECK records a failure and carries on, so one run reports
+// every broken expectation.
+namespace testing {
+
+struct Case {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<Case>& cases() {
+    static std::vector<Case> list;
+    return list;
+}
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const char* expression) {
+    std::cerr << "  " << file << ":" << line << ": CHECK(" << expression << ") failed\n";
+    failures()++;
+}
+
+struct Register {
+    Register(const char* name, void (*run)()) { cases().push_back({ name, run }); }
+};
+
+// Scratch file in the temp directory, removed when the test is done with it
+struct TempFile {
+    std::filesystem::path path;
+
+    explicit TempFile(const std::string& name)
+        : path(std::filesystem::temp_directory_path() / ("fluid_test_" + name)) {}
+    ~TempFile() {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+    std::string string() const { return path.string(); }
+};
+
+// Two species laid out like the built-in scenes, with random motion
+inline std::vector<Particle> randomParticles(uint32_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-400.0f, 400.0f), velocity(-30.0f, 30.0f);
+    const glm::vec4 colours[2] = { { 0.2f, 0.6f, 1.0f, 1.0f }, { 1.0f, 0.55f, 0.2f, 1.0f } };
+    std::vector<Particle> particles(count);
+    for (Particle& p : particles) {
+        int species = static_cast<int>(rng() % 2);
+        p.pos_radius = glm::vec4(position(rng), position(rng) * 0.75f, 1.0f, species ? 14.0f : 10.0f);
+        p.velocity = glm::vec4(velocity(rng), velocity(rng), 0.0f, static_cast<float>(species));
+        p.color = colours[species];
+    }
+    return particles;
+}
+
+} // namespace testing
+
+#define TEST(name)                                                        \
+    static void test_##name();                                            \
+    static testing::Register register_##name(#name, test_##name);         \
+    static void test_##name()
+
+#define CHECK(expression)                                                 \
+    do {                                                                  \
+        if (!(expression)) testing::fail(__FILE__, __LINE__, #expression); \
+    } while (0)
+
+#endif // TESTING_H
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "testing.h"
+#include "trajectory.h"
+
+namespace {
+
+// 'frames' states of a drifting particle set, written with 'options'
+std::vector<std::vector<Particle>> record(const testing::TempFile& file, const trajectory::Options& options, int frames) {
+    std::vector<Particle> particles = testing::randomParticles(700, 21);
+    std::vector<std::vector<Particle>> states;
+    trajectory::Writer writer;
+    // A small index, so it has to grow while recording
+    CHECK(writer.open(file.string(), options, 4));
+    for (int f = 0; f < frames; f++) {
+        for (Particle& p : particles) {
+            p.pos_radius.x += p.velocity.x * 0.016f;
+            p.pos_radius.y += p.velocity.y * 0.016f;
+            p.velocity.y -= 9.8f * 0.016f;
+        }
+        states.push_back(particles);
+        CHECK(writer.append(particles.data(), static_cast<uint32_t>(particles.size()), f * 0.016));
+    }
+    CHECK(writer.frames() == static_cast<uint64_t>(frames));
+    writer.close();
+    return states;
+}
+
+} // namespace
+
+TEST(trajectoryRawRoundTrip) {
+    testing::TempFile file("raw.traj");
+    auto states = record(file, trajectory::Options{}, 12);
+
+    trajectory::Reader reader;
+    CHECK(reader.open(file.string()));
+    CHECK(reader.frames() == states.size());
+    std::vector<Particle> out;
+    for (uint64_t f : { 11, 0, 5 }) {
+        CHECK(reader.read(f, out));
+        CHECK(out.size() == states[f].size());
+        CHECK(std::memcmp(out.data(), states[f].data(), out.size() * sizeof(Particle)) == 0);
+    }
+    CHECK(!reader.read(12, out));
+    CHECK(reader.frameAt(5 * 0.016 + 0.001) == 5);
+}
+
+TEST(trajectoryQuantizedRoundTrip) {
+    testing::TempFile file("quantized.traj");
+    trajectory::Options options;
+    options.encoding = trajectory::Encoding::Quantized;
+    options.keyframeInterval = 5;
+    auto states = record(file, options, 13);
+
+    trajectory::Reader reader;
+    CHECK(reader.open(file.string()));
+    std::vector<Particle> out;
+    int deltas = 0;
+    for (uint64_t f = 0; f < states.size(); f++) {
+        trajectory::IndexEntry entry = reader.entry(f);
+        CHECK(entry.kind == (f % 5 == 0 ? trajectory::FrameKind::Raw : trajectory::FrameKind::Delta));
+        deltas += entry.kind == trajectory::FrameKind::Delta;
+
+        CHECK(reader.read(f, out));
+        CHECK(out.size() == states[f].size());
+        float positionError = 0.0f, velocityError = 0.0f;
+        bool restExact = true;
+        for (size_t i = 0; i < out.size(); i++) {
+            const Particle& a = out[i];
+            const Particle& b = states[f][i];
+            positionError = std::max({ positionError, std::fabs(a.pos_radius.x - b.pos_radius.x), std::fabs(a.pos_radius.y - b.pos_radius.y) });
+            velocityError = std::max({ velocityError, std::fabs(a.velocity.x - b.velocity.x), std::fabs(a.velocity.y - b.velocity.y) });
+            restExact &= a.pos_radius.z == b.pos_radius.z && a.pos_radius.w == b.pos_radius.w && a.velocity.w == b.velocity.w &&
+                         a.color == b.color;
+        }
+        // Half a quantum, plus float rounding at these magnitudes
+        CHECK(positionError <= options.positionQuantum * 0.5f + 1e-4f);
+        CHECK(velocityError <= options.velocityQuantum * 0.5f + 1e-4f);
+        CHECK(restExact);
+    }
+    CHECK(deltas == 10);
+}
+
+TEST(trajectoryRejectsDamagedDelta) {
+    testing::TempFile file("damaged.traj");
+    trajectory::Options options;
+    options.encoding = trajectory::Encoding::Quantized;
+    record(file, options, 3);
+
+    // Cut frame 1's byte count short, so its varints run past the frame
+    trajectory::Header header;
+    {
+        std::ifstream in(file.path, std::ios::binary);
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    }
+    {
+        std::fstream io(file.path, std::ios::binary | std::ios::in | std::ios::out);
+        io.seekp(static_cast<std::streamoff>(header.indexOffset + sizeof(trajectory::IndexEntry) + offsetof(trajectory::IndexEntry, bytes)));
+        uint32_t bytes = 3;
+        io.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+    }
+
+    trajectory::Reader reader;
+    CHECK(reader.open(file.string()));
+    std::vector<Particle> out;
+    CHECK(reader.entry(1).kind == trajectory::FrameKind::Delta);
+    CHECK(!reader.read(1, out));
+    CHECK(reader.read(2, out));
+}
+
+TEST(trajectoryQuantizedExtremes) {
+    // A particle crossing most of the quantized range between keyframe and
+    // delta frame, and one that blew up
+    testing::TempFile file("extremes.traj");
+    trajectory::Options options;
+    options.encoding = trajectory::Encoding::Quantized;
+    std::vector<Particle> particles = testing::randomParticles(4, 22);
+    particles[0].pos_radius.x = -5.0e6f;
+    trajectory::Writer writer;
+    CHECK(writer.open(file.string(), options));
+    CHECK(writer.append(particles.data(), 4, 0.0));
+    particles[0].pos_radius.x = 5.0e6f;
+    particles[1].velocity.y = NAN;
+    particles[2].pos_radius.y = INFINITY;
+    CHECK(writer.append(particles.data(), 4, 0.016));
+    writer.close();
+
+    trajectory::Reader reader;
+    CHECK(reader.open(file.string()));
+    std::vector<Particle> out;
+    CHECK(reader.entry(1).kind == trajectory::FrameKind::Delta);
+    CHECK(reader.read(1, out));
+    CHECK(out.size() == 4 && out[0].pos_radius.x == 5.0e6f);
+    CHECK(out.size() == 4 && out[1].velocity.y == 0.0f && out[2].pos_radius.y == 0.0f);
+    CHECK(out.size() == 4 && std::fabs(out[3].pos_radius.x - particles[3].pos_radius.x) <= options.positionQuantum);
+}
@@ -0,0 +1,32 @@
+#include <atomic>
+#include <vector>
+
+#include "testing.h"
+#include "workStealingPool.h"
+
+TEST(parallelForCoversEveryItemOnce) {
+    WorkStealingPool pool(4);
+    std::vector<std::atomic<int>> hits(10000);
+    pool.parallelFor(0, static_cast<uint32_t>(hits.size()), 7, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) hits[i]++;
+    });
+    bool once = true;
+    for (const std::atomic<int>& h : hits) once &= h.load() == 1;
+    CHECK(once);
+}
+
+TEST(parallelForAcrossPools) {
+    // Workers of the larger pool call into the smaller one, whose deques they
+    // do not own; they must use it as any outside thread would
+    WorkStealingPool outer(4), inner(2);
+    std::atomic<uint64_t> sum{ 0 };
+    outer.parallelFor(0, 64, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            inner.parallelFor(0, 100, 3, [&](uint32_t lo, uint32_t hi) {
+                // And nested within the same pool
+                inner.parallelFor(lo, hi, 1, [&](uint32_t a, uint32_t b) { sum += b - a; });
+            });
+        }
+    });
+    CHECK(sum.load() == 64u * 100u);
+}
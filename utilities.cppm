@@ -1,24 +1,28 @@
 module;
 
+#include <cstdint>
 #include <cstdlib>
-#include <ctime>
 #include <iostream>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "philox.h"
+
 export module utilities;
 
-export glm::vec2 randomDirection2D() {
-    float angle = static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.0f * 3.14159265f;
+// Draw from the caller's stream (main's seeded rng), so --deterministic
+// --seed covers these too; the module keeps no generator of its own
+export glm::vec2 randomDirection2D(PhiloxStream& stream) {
+    float angle = stream.nextFloat() * 2.0f * 3.14159265f;
     return glm::vec2(cos(angle), sin(angle));
 }
 
-export glm::vec4 randomColour() {
+export glm::vec4 randomColour(PhiloxStream& stream) {
     return glm::vec4(
-        static_cast<float>(rand()) / static_cast<float>(RAND_MAX),
-        static_cast<float>(rand()) / static_cast<float>(RAND_MAX),
-        static_cast<float>(rand()) / static_cast<float>(RAND_MAX),
+        stream.nextFloat(),
+        stream.nextFloat(),
+        stream.nextFloat(),
         1.0f
     );
-}
\ No newline at end of file
+}